@@ -46,6 +46,139 @@ using std::map;
 using std::vector;
 
 
+// ———  compiled program  ———
+
+/* Trees are compiled into one flat array of instructions, shared by all trees.
+ * Branching instructions hold the indices of the instructions to continue
+ * with; thresholds of random and age switches and the details of actions are
+ * held in separate tables, indexed by the instruction's argument. Executing a
+ * tree is then a loop over instructions, with recursion only for 'multiple'
+ * nodes. */
+namespace program {
+    enum OpCode {
+        MULTIPLE,       // run targets[arg .. arg+a) in turn
+        CASE_TYPE,      // continue at a (first line) or b (second line)
+        DIAGNOSTIC,     // use diagnostics[arg]: continue at a (positive) or b
+        RANDOM,         // switch on a uniform sample; a branches from arg
+        AGE,            // switch on age; a branches from arg
+        NO_TREATMENT,
+        TREAT_FAILURE,
+        TREAT_PKPD,     // treatments[arg .. arg+a)
+        TREAT_SIMPLE,   // simpleTreatments[arg]
+        DEPLOY          // deployments[arg]
+    };
+    struct Instruction {
+        Instruction( OpCode op, uint32_t arg, uint32_t a = 0, uint32_t b = 0 ) :
+            op(op), arg(arg), a(a), b(b) {}
+        OpCode op;
+        uint32_t arg, a, b;
+    };
+    
+    struct TreatInfo{
+        TreatInfo( const string& s, const string& d, double h ) :
+            schedule(PkPd::LSTMTreatments::findSchedule(s)),
+            dosage(PkPd::LSTMTreatments::findDosages(d)),
+            delay_h(h) {}
+        inline bool operator!=( const TreatInfo& that )const{
+            return schedule != that.schedule ||
+                dosage != that.dosage ||
+                delay_h != that.delay_h;
+        }
+        size_t schedule;        // index of the schedule
+        size_t dosage;          // name of the dosage table
+        double delay_h;         // delay in hours
+    };
+    struct SimpleTreatment{
+        SimpleTreatment( SimTime l, SimTime b ) : timeLiver(l), timeBlood(b) {}
+        SimTime timeLiver, timeBlood;
+    };
+    
+    vector<Instruction> code;
+    // For switches: keys (cumulative probability for random switches, upper
+    // bounds for age switches) and the corresponding branches
+    vector<double> thresholds;
+    vector<uint32_t> targets;
+    vector<const Diagnostic*> diagnostics;
+    vector<TreatInfo> treatments;
+    vector<SimpleTreatment> simpleTreatments;
+    vector<const interventions::HumanIntervention*> deployments;
+    
+    inline uint32_t emit( const Instruction& instr ){
+        code.push_back( instr );
+        return code.size() - 1;
+    }
+    /// Index of first branch whose key is greater than x (as map::upper_bound)
+    inline uint32_t select( const Instruction& instr, double x ){
+        const double *keys = &thresholds[instr.arg];
+        uint32_t i = 0;
+        while( i < instr.a && !(x < keys[i]) ) ++i;
+        return i;
+    }
+    
+    bool run( uint32_t pc, CMHostData& hostData ){
+        for( ;; ){
+            const Instruction& instr = code[pc];
+            switch( instr.op ){
+            case MULTIPLE: {
+                bool treated = false;
+                for( uint32_t i = instr.arg, end = instr.arg + instr.a; i < end; ++i ){
+                    if( run( targets[i], hostData ) ) treated = true;
+                }
+                return treated; }
+            case CASE_TYPE:
+                // Uses of this in complicated cases should trigger an exception during initialisation.
+                assert( (hostData.pgState & Episode::SICK) && !(hostData.pgState & Episode::COMPLICATED) );
+                pc = (hostData.pgState & Episode::SECOND_CASE) ? instr.b : instr.a;
+                break;
+            case DIAGNOSTIC:
+                mon::reportEventMHI( mon::MHT_TREAT_DIAGNOSTICS, hostData.human, 1 );
+                pc = hostData.withinHost().diagnosticResult( *diagnostics[instr.arg] ) ?
+                    instr.a : instr.b;
+                break;
+            case RANDOM: {
+                uint32_t i = select( instr, random::uniform_01() );
+                assert( i < instr.a );
+                pc = targets[instr.arg + i];
+                break; }
+            case AGE: {
+                // age is that of human at start of time step (i.e. may be as low as 0)
+                uint32_t i = select( instr, hostData.ageYears );
+                if( i == instr.a )
+                    throw TRACED_EXCEPTION( "bad age-based decision tree switch", util::Error::PkPd );
+                pc = targets[instr.arg + i];
+                break; }
+            case NO_TREATMENT:
+                return false;
+            case TREAT_FAILURE:
+                return true;    // report treatment
+            case TREAT_PKPD:
+                for( uint32_t i = instr.arg, end = instr.arg + instr.a; i < end; ++i ){
+                    hostData.withinHost().treatPkPd( treatments[i].schedule,
+                            treatments[i].dosage, hostData.ageYears );
+                }
+                return true;
+            case TREAT_SIMPLE: {
+                const SimpleTreatment& treat = simpleTreatments[instr.arg];
+                return hostData.withinHost().treatSimple( hostData.human,
+                        treat.timeLiver, treat.timeBlood ); }
+            case DEPLOY:
+                deployments[instr.arg]->deploy( hostData.human,
+                        mon::Deploy::TREAT,
+                        interventions::VaccineLimits(/*default initialise: no limits*/) );
+                //NOTE: it's not intuitively obvious what value should be returned here
+                // in the case of intervention deployment. This at least means that
+                // repeat seekers get second-line treatment.
+                return true;
+            }
+        }
+    }
+}
+
+CMDTOut CMDecisionTree::exec( CMHostData hostData ) const{
+    return CMDTOut( program::run( entry, hostData ) );
+}
+
+
 // ———  special 'multiple' node  ———
 
 /**
@@ -67,15 +200,15 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        CMDTOut result(false);
+    virtual uint32_t compile() const{
+        const uint32_t offset = program::targets.size();
         for( Children_t::const_iterator it = children.begin(),
             end = children.end(); it != end; ++it )
         {
-            CMDTOut r2 = (*it)->exec( hostData );
-            result.treated = result.treated || r2.treated;
+            program::targets.push_back( entryOf( **it ) );
         }
-        return result;
+        return program::emit( program::Instruction( program::MULTIPLE,
+                offset, children.size() ) );
     }
     
 private:
@@ -106,12 +239,9 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        // Uses of this in complicated cases should trigger an exception during initialisation.
-        assert( (hostData.pgState & Episode::SICK) && !(hostData.pgState & Episode::COMPLICATED) );
-        
-        if( hostData.pgState & Episode::SECOND_CASE ) return secondLine.exec( hostData );
-        else return firstLine.exec( hostData );
+    virtual uint32_t compile() const{
+        return program::emit( program::Instruction( program::CASE_TYPE, 0,
+                entryOf( firstLine ), entryOf( secondLine ) ) );
     }
     
 private:
@@ -142,13 +272,11 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        mon::reportEventMHI( mon::MHT_TREAT_DIAGNOSTICS, hostData.human, 1 );
-        if( hostData.withinHost().diagnosticResult( diagnostic ) ){
-            return positive.exec( hostData );
-        }else{
-            return negative.exec( hostData );
-        }
+    virtual uint32_t compile() const{
+        program::diagnostics.push_back( &diagnostic );
+        return program::emit( program::Instruction( program::DIAGNOSTIC,
+                program::diagnostics.size() - 1,
+                entryOf( positive ), entryOf( negative ) ) );
     }
     
 private:
@@ -189,10 +317,14 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        Branches_t::const_iterator it =branches.upper_bound( random::uniform_01() );
-        assert( it != branches.end() );
-        return it->second->exec( hostData );
+    virtual uint32_t compile() const{
+        const uint32_t offset = program::thresholds.size();
+        for( Branches_t::const_iterator it = branches.begin(); it != branches.end(); ++it ){
+            program::thresholds.push_back( it->first );
+            program::targets.push_back( entryOf( *it->second ) );
+        }
+        return program::emit( program::Instruction( program::RANDOM,
+                offset, branches.size() ) );
     }
     
 private:
@@ -225,12 +357,14 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        // age is that of human at start of time step (i.e. may be as low as 0)
-        Branches_t::const_iterator it = branches.upper_bound( hostData.ageYears );
-        if( it == branches.end() )
-            throw TRACED_EXCEPTION( "bad age-based decision tree switch", util::Error::PkPd );
-        return it->second->exec( hostData );
+    virtual uint32_t compile() const{
+        const uint32_t offset = program::thresholds.size();
+        for( Branches_t::const_iterator it = branches.begin(); it != branches.end(); ++it ){
+            program::thresholds.push_back( it->first );
+            program::targets.push_back( entryOf( *it->second ) );
+        }
+        return program::emit( program::Instruction( program::AGE,
+                offset, branches.size() ) );
     }
     
 private:
@@ -253,8 +387,8 @@ protected:
         return p != 0;  // same type: is equivalent
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        return CMDTOut(false);
+    virtual uint32_t compile() const{
+        return program::emit( program::Instruction( program::NO_TREATMENT, 0 ) );
     }
 };
 
@@ -267,8 +401,8 @@ protected:
         return p != 0;  // same type: is equivalent
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        return CMDTOut(true /*report treatment*/);
+    virtual uint32_t compile() const{
+        return program::emit( program::Instruction( program::TREAT_FAILURE, 0 ) );
     }
 };
 
@@ -303,28 +437,16 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        foreach( const TreatInfo& treatment, treatments ){
-            hostData.withinHost().treatPkPd( treatment.schedule, treatment.dosage, hostData.ageYears );
-        }
-        return CMDTOut(true);
+    virtual uint32_t compile() const{
+        const uint32_t offset = program::treatments.size();
+        program::treatments.insert( program::treatments.end(),
+                treatments.begin(), treatments.end() );
+        return program::emit( program::Instruction( program::TREAT_PKPD,
+                offset, treatments.size() ) );
     }
     
 private:
-    struct TreatInfo{
-        TreatInfo( const string& s, const string& d, double h ) :
-            schedule(PkPd::LSTMTreatments::findSchedule(s)),
-            dosage(PkPd::LSTMTreatments::findDosages(d)),
-            delay_h(h) {}
-        inline bool operator!=( const TreatInfo& that )const{
-            return schedule != that.schedule ||
-                dosage != that.dosage ||
-                delay_h != that.delay_h;
-        }
-        size_t schedule;        // index of the schedule
-        size_t dosage;          // name of the dosage table
-        double delay_h;         // delay in hours
-    };
+    typedef program::TreatInfo TreatInfo;
     vector<TreatInfo> treatments;
 };
 
@@ -361,9 +483,11 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        bool bsTreatment = hostData.withinHost().treatSimple( hostData.human, timeLiver, timeBlood );
-        return CMDTOut(bsTreatment);
+    virtual uint32_t compile() const{
+        program::simpleTreatments.push_back(
+                program::SimpleTreatment( timeLiver, timeBlood ) );
+        return program::emit( program::Instruction( program::TREAT_SIMPLE,
+                program::simpleTreatments.size() - 1 ) );
     }
     
 private:
@@ -396,15 +520,10 @@ protected:
         return true;    // no tests failed; must be the same
     }
     
-    virtual CMDTOut exec( CMHostData hostData ) const{
-        deploy( hostData.human,
-                  mon::Deploy::TREAT,
-                  interventions::VaccineLimits(/*default initialise: no limits*/) );
-        
-        //NOTE: it's not intuitively obvious what value should be returned here
-        // in the case of intervention deployment. This at least means that
-        // repeat seekers get second-line treatment.
-        return CMDTOut(true);
+    virtual uint32_t compile() const{
+        program::deployments.push_back( this );
+        return program::emit( program::Instruction( program::DEPLOY,
+                program::deployments.size() - 1 ) );
     }
 };
 
@@ -414,9 +533,7 @@ protected:
 // Memory management: lists all decisions and frees memory at program exit
 ptr_vector<CMDecisionTree> decision_library;
 
-// Saves a decision to decision_library, making it const.
-// Also optimises away duplicates
-const CMDecisionTree& save_decision( CMDecisionTree* decision ){
+const CMDecisionTree& CMDecisionTree::save_decision( CMDecisionTree* decision ){
     // We search the library for a duplicate, and delete this one if there is
     // a duplicate. Note that this is not implemented efficiently, but a little
     // wasted time at start up is hardly a concern.
@@ -429,6 +546,7 @@ const CMDecisionTree& save_decision( CMDecisionTree* decision ){
     
     // No match: add to the library.
     decision_library.push_back( decision );
+    decision->entry = decision->compile();
     return *decision;
 }
 
@@ -57,6 +57,11 @@ struct CMDTOut {
  * 
  * Sub-classes represent either a decision node (first/second line case, a
  * diagnostic with positive/negative outcome, a random decision) or an action.
+ * 
+ * Nodes are only used while loading: each node is compiled, when created, into
+ * a flat program shared by all trees (see CMDecisionTree.cpp), and exec()
+ * interprets this program. Since equivalent nodes are de-duplicated before
+ * compilation, sub-trees common to several trees are compiled only once.
  *****************************************************************************/
 class CMDecisionTree {
 public:
@@ -85,8 +90,28 @@ public:
      * 
      * Reporting: use of diagnostics is reported. Treatment is not, but the
      * output may be used to determine whether any treatment took place. */
-    virtual CMDTOut exec( CMHostData hostData ) const =0;
+    CMDTOut exec( CMHostData hostData ) const;
+    
+protected:
+    CMDecisionTree() : entry(0) {}
+    
+    /** Append instructions for this node to the program and return the index
+     * of the first. Sub-nodes are already compiled (see entry). */
+    virtual uint32_t compile() const =0;
+    
+    /** Saves a decision to the library, making it const and compiling it.
+     * Returns an equivalent decision already in the library if there is one,
+     * deleting the argument. */
+    static const CMDecisionTree& save_decision( CMDecisionTree* decision );
+    
+    /// Entry point of a saved node
+    static inline uint32_t entryOf( const CMDecisionTree& node ){
+        return node.entry;
+    }
+    
+private:
+    /// Index of this node's first instruction in the program
+    uint32_t entry;
 };
-
 } }
 #endif
\ No newline at end of file
@@ -29,6 +29,7 @@
 #include "util/ModelOptions.h"
 #include "util/CommandLine.h"
 #include "util/errors.h"
+#include "util/parallel.h"
 #include "util/timeConversions.h"
 #include "schema/scenario.h"
 
@@ -122,6 +123,8 @@ bool ClinicalModel::isDead( SimTime age ){
 }
 
 void ClinicalModel::update (Human& human, double ageYears, bool newBorn) {
+    latestReport.expire();
+    
     if (doomed < NOT_DOOMED)	// Countdown to indirect mortality
         doomed -= sim::oneTS().inDays();
     
@@ -147,11 +150,11 @@ void ClinicalModel::updateInfantDeaths( SimTime age ){
     // update array for the infant death rates
     if (age < sim::oneYear()){
         size_t index = age / sim::oneTS();
-        infantIntervalsAtRisk[index] += 1;     // baseline
+        util::parallel::atomicAdd( infantIntervalsAtRisk[index], 1 );     // baseline
         // Testing doomed == DOOMED_NEXT_TS gives very slightly different results than
         // testing doomed == DOOMED_INDIRECT (due to above if(..))
         if( doomed == DOOMED_COMPLICATED || doomed == DOOMED_NEXT_TS || doomed == DOOMED_NEONATAL ){
-            infantDeaths[index] += 1;  // deaths
+            util::parallel::atomicAdd( infantDeaths[index], 1 );  // deaths
         }
     }
 }
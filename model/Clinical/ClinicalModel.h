@@ -23,6 +23,7 @@
 
 #include "Host/Human.h"
 #include "Episode.h"
+#include "util/SlabPool.h"
 #include <memory>
 
 namespace scnXml{
@@ -65,6 +66,14 @@ public:
     /// Destructor
     virtual ~ClinicalModel ();
     
+    /// Instances are allocated from slabs, one pool per derived type
+    static void* operator new( size_t size ){
+        return util::slab::allocate( size );
+    }
+    static void operator delete( void* p, size_t size ){
+        util::slab::deallocate( p, size );
+    }
+    
     /** Returns true if the human has been killed by some means.
      * 
      * Also kills the human if he/she reaches the simulation age limit.
@@ -35,6 +35,11 @@ void Episode::flush() {
     time = sim::never();
 }
 
+void Episode::expire() {
+    if( time >= sim::zero() && time + healthSystemMemory < sim::ts0() ){
+        flush();
+    }
+}
 
 void Episode::update (const Host::Human& human, Episode::State newState)
 {
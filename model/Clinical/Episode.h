@@ -87,6 +87,12 @@ public:
     /// Report anything pending, as on destruction
     void flush();
     
+    /** Report the episode if the health-system memory has passed since it
+     * started; update() would do the same when the next episode starts. Called
+     * every step so that reports to past surveys are made promptly (see
+     * mon::concludeSurvey). */
+    void expire();
+    
     /** Report an episode, its severity, and any outcomes it entails.
      *
      * @param human The human whose info is being reported
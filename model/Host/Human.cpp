@@ -30,6 +30,8 @@
 #include "util/ModelOptions.h"
 #include "util/vectors.h"
 #include "util/StreamValidator.h"
+#include "util/parallel.h"
+#include "util/timer.h"
 #include "Population.h"
 #include "interventions/InterventionManager.hpp"
 #include "mon/reporting.h"
@@ -40,12 +42,16 @@ namespace OM { namespace Host {
     using interventions::ComponentId;
     
     bool surveyOnlyNewEp = false;
+    
+    // cache; one per partition of a multi-threaded update (see util::parallel)
+    vector<vector<double> > EIR_per_genotype;
 
 // -----  Static functions  -----
 
 void Human::init( const Parameters& parameters, const scnXml::Scenario& scenario ){    // static
     HumanHet::init();
     surveyOnlyNewEp = scenario.getMonitoring().getSurveyOptions().getOnlyNewEpisode();
+    EIR_per_genotype.resize( util::parallel::numThreads() );
     
     const scnXml::Model& model = scenario.getModel();
     // Init models used by humans:
@@ -59,31 +65,53 @@ void Human::init( const Parameters& parameters, const scnXml::Scenario& scenario
 // -----  Non-static functions: creation/destruction, checkpointing  -----
 
 // Create new human
-Human::Human(Transmission::TransmissionModel& tm, SimTime dateOfBirth) :
-    infIncidence(InfectionIncidenceModel::createModel()),
+Human::Human(Transmission::TransmissionModel& tm, SimTime dateOfBirth, uint64_t id) :
     m_DOB(dateOfBirth),
     m_cohortSet(0),
-    nextCtsDist(0)
+    m_rng(id)
 {
   // Initial humans are created at time 0 and may have DOB in past. Otherwise DOB must be now.
   assert( m_DOB == sim::nowOrTs1() || (sim::now() == sim::zero() && m_DOB < sim::now()) );
   
+  random::HumanContext rngContext( m_rng, random::PURPOSE_BIRTH );
+  infIncidence = InfectionIncidenceModel::createModel();
   HumanHet het = HumanHet::sample();
   withinHostModel = WithinHost::WHInterface::createWithinHostModel( het.comorbidityFactor );
   perHostTransmission.initialise (tm, het.availabilityFactor * infIncidence->getAvailabilityFactor(1.0));
   clinicalModel = Clinical::ClinicalModel::createClinicalModel (het.treatmentSeekingFactor);
 }
 
+Human::Human(istream& stream) :
+    withinHostModel(0),
+    infIncidence(0),
+    clinicalModel(0),
+    m_DOB(sim::never()),
+    m_cohortSet(0)
+{
+    // Factors passed here are read back from the checkpoint below. The
+    // within-host constructors still sample random numbers; this is harmless
+    // only because the generator's state is restored after the population.
+    infIncidence = InfectionIncidenceModel::createModel();
+    withinHostModel = WithinHost::WHInterface::createWithinHostModel( 1.0 );
+    clinicalModel = Clinical::ClinicalModel::createClinicalModel( 1.0 );
+    try{
+        (*this) & stream;
+    }catch(...){
+        destroy();
+        throw;
+    }
+}
+
 Human::Human(SimTime dateOfBirth) :
     withinHostModel(0),
     infIncidence(0),
     clinicalModel(0),
     m_DOB(dateOfBirth),
-    m_cohortSet(0),
-    nextCtsDist(0)
+    m_cohortSet(0)
 {}
 
 void Human::destroy() {
+  SubPopMembership::unlist( *this );
   delete infIncidence;
   delete withinHostModel;
   delete clinicalModel;
@@ -92,14 +120,19 @@ void Human::destroy() {
 
 // -----  Non-static functions: per-time-step update  -----
 
-vector<double> EIR_per_genotype;        // cache (not thread safe)
+void Human::resetMonAgeGroup(){
+    // update() last set this for the start of the previous step
+    monitoringAgeGroup = mon::AgeGroup();
+    monitoringAgeGroup.update( age(sim::now() - sim::oneTS()) );
+}
 
 bool Human::update(Transmission::TransmissionModel* transmissionModel, bool doUpdate) {
 #ifdef WITHOUT_BOINC
-    ++PopulationStats::humanUpdateCalls;
+    util::parallel::atomicAdd( PopulationStats::humanUpdateCalls, 1 );
     if( doUpdate )
-        ++PopulationStats::humanUpdates;
+        util::parallel::atomicAdd( PopulationStats::humanUpdates, 1 );
 #endif
+    random::HumanContext rngContext( m_rng, random::PURPOSE_UPDATE );
     // For integer age checks we use age0 to e.g. get 73 steps comparing less than 1 year old
     SimTime age0 = age(sim::ts0());
     if (clinicalModel->isDead(age0))
@@ -115,30 +148,28 @@ bool Human::update(Transmission::TransmissionModel* transmissionModel, bool doUp
         // monitoringAgeGroup is the group for the start of the time step.
         monitoringAgeGroup.update( age0 );
         // check sub-pop expiry
-        for( map<ComponentId,SimTime>::iterator expIt =
-            m_subPopExp.begin(), expEnd = m_subPopExp.end(); expIt != expEnd; )
-        {
-            if( !(expIt->second >= sim::ts0()) ){       // membership expired
+        for( size_t i = m_subPops.next( 0 ); i < m_subPops.end(); i = m_subPops.next( i + 1 ) ){
+            ComponentId id( i );
+            if( !(m_subPops.expiry( id ) >= sim::ts0()) ){       // membership expired
                 // don't flush reports
                 // report removal due to expiry
                 mon::reportEventMHI( mon::MHR_SUB_POP_REM_TOO_OLD, *this, 1 );
-                m_cohortSet = mon::updateCohortSet( m_cohortSet, expIt->first, false );
-                // erase element, but continue iteration (note: this is simpler in C++11)
-                map<ComponentId,SimTime>::iterator toErase = expIt;
-                ++expIt;
-                m_subPopExp.erase( toErase );
-            }else{
-                ++expIt;
+                m_cohortSet = mon::updateCohortSet( m_cohortSet, id, false );
+                m_subPops.erase( id );
             }
         }
         // ageYears1 used only in PerHost::relativeAvailabilityAge(); difference to age0 should be minor
+        vector<double>& EIR_genotype = EIR_per_genotype[util::parallel::partition()];
         double EIR = transmissionModel->getEIR( *this, age0, ageYears1,
-                EIR_per_genotype );
+                EIR_genotype );
         int nNewInfs = infIncidence->numNewInfections( *this, EIR );
         
         // ageYears1 used when medicating drugs (small effect) and in immunity model (which was parameterised for it)
-        withinHostModel->update(nNewInfs, EIR_per_genotype, ageYears1,
-                _vaccine.getFactor(interventions::Vaccine::BSV));
+        {
+            OM_PROFILE_SCOPE( WITHIN_HOST_UPDATE );
+            withinHostModel->update(nNewInfs, EIR_genotype, ageYears1,
+                    _vaccine.getFactor(interventions::Vaccine::BSV));
+        }
         
         // ageYears1 used to get case fatality and sequelae probabilities, determine pathogenesis
         clinicalModel->update( *this, ageYears1, age0 == sim::zero() );
@@ -163,6 +194,7 @@ void Human::summarize() {
         return;
     }
     
+    random::HumanContext rngContext( m_rng, random::PURPOSE_SURVEY );
     mon::reportStatMHI( mon::MHR_HOSTS, *this, 1 );
     mon::reportStatMHF( mon::MHF_AGE, *this, age(sim::now()).inYears() );
     bool patent = withinHostModel->summarize (*this);
@@ -176,15 +208,15 @@ void Human::summarize() {
 
 void Human::reportDeployment( ComponentId id, SimTime duration ){
     if( duration <= sim::zero() ) return; // nothing to do
-    m_subPopExp[id] = sim::nowOrTs1() + duration;
+    m_subPops.set( id, sim::nowOrTs1() + duration, *this );
     m_cohortSet = mon::updateCohortSet( m_cohortSet, id, true );
 }
 void Human::removeFirstEvent( interventions::SubPopRemove::RemoveAtCode code ){
     const vector<ComponentId>& removeAtList = interventions::removeAtIds[code];
     for( vector<ComponentId>::const_iterator it = removeAtList.begin(), end = removeAtList.end(); it != end; ++it ){
-        SubPopT::iterator expIt = m_subPopExp.find( *it );
-        if( expIt != m_subPopExp.end() ){
-            if( expIt->second > sim::nowOrTs0() ){
+        SimTime expiry = m_subPops.expiry( *it );
+        if( expiry != sim::never() ){
+            if( expiry > sim::nowOrTs0() ){
                 // removeFirstEvent() is used for onFirstBout, onFirstTreatment
                 // and onFirstInfection cohort options. Health system memory must
                 // be reset for this to work properly; in theory the memory should
@@ -194,9 +226,9 @@ void Human::removeFirstEvent( interventions::SubPopRemove::RemoveAtCode code ){
                 // report removal due to first infection/bout/treatment
                 mon::reportEventMHI( mon::MHR_SUB_POP_REM_FIRST_EVENT, *this, 1 );
             }
-            m_cohortSet = mon::updateCohortSet( m_cohortSet, expIt->first, false );
+            m_cohortSet = mon::updateCohortSet( m_cohortSet, *it, false );
             // remove (affects reporting, restrictToSubPop and cumulative deployment):
-            m_subPopExp.erase( expIt );
+            m_subPops.erase( *it );
         }
     }
 }
@@ -23,9 +23,11 @@
 #include "Global.h"
 #include "Transmission/PerHost.h"
 #include "InfectionIncidenceModel.h"
+#include "Host/SubPopMembership.h"
 #include "mon/AgeGroup.h"
 #include "interventions/HumanComponents.h"
 #include "util/checkpoint_containers.h"
+#include "util/random.h"
 #include <map>
 
 class UnittestUtil;
@@ -56,8 +58,21 @@ public:
   /** Initialise all variables of a human datatype.
    * 
    * \param tm Transmission model reference (to initialize TM code)
-   * \param dateOfBirth date of birth (usually start of next time step) */
-  Human(Transmission::TransmissionModel& tm, SimTime dateOfBirth);
+   * \param dateOfBirth date of birth (usually start of next time step)
+   * \param id Unique identifier, used to key this human's random number
+   *    streams (see util::random::HumanContext) */
+  Human(Transmission::TransmissionModel& tm, SimTime dateOfBirth, uint64_t id);
+  
+  /** Load a human from a checkpoint.
+   * 
+   * Sub-models are created directly in the configured types and then read
+   * from the stream, skipping heterogeneity sampling and PerHost
+   * initialisation. Sub-model constructors do still draw random numbers
+   * (e.g. innate immunity in WHFalciparum, the mass multiplier in
+   * CommonWithinHost, WHVivax); results are unaffected only because the
+   * random number generator state is read from the checkpoint after the
+   * population. */
+  explicit Human(istream& stream);
 
   /** Destructor
    * 
@@ -82,8 +97,8 @@ public:
       _vaccine & stream;
       monitoringAgeGroup & stream;
       m_cohortSet & stream;
-      nextCtsDist & stream;
-      m_subPopExp & stream;
+      m_subPops & stream;
+      m_rng & stream;
   }
   //@}
   
@@ -103,7 +118,7 @@ public:
   void reportDeployment( interventions::ComponentId id, SimTime duration );
   
   inline void removeFromSubPop( interventions::ComponentId id ){
-      m_subPopExp.erase( id );
+      m_subPops.erase( id );
   }
   
   /// Resets immunity
@@ -124,20 +139,16 @@ public:
    * 
    * @param id Sub-population identifier. */
   inline bool isInSubPop( interventions::ComponentId id )const{
-      map<interventions::ComponentId,SimTime>::const_iterator it = m_subPopExp.find( id );
-      if( it == m_subPopExp.end() ) return false;       // no history of membership
-      else return it->second > sim::nowOrTs0();   // added: has expired?
+      // sim::never() if no history of membership; otherwise: has expired?
+      return m_subPops.expiry( id ) > sim::nowOrTs0();
   }
   /** Return the cohort set. */
   inline uint32_t cohortSet()const{ return m_cohortSet; }
   
-  /// Return the index of next continuous intervention to be deployed
-  inline uint32_t getNextCtsDist()const{ return nextCtsDist; }
-  /// Increment then return index of next continuous intervention to deploy
-  inline uint32_t incrNextCtsDist() {
-      nextCtsDist += 1;
-      return nextCtsDist;
-  }
+  /// Random number streams of this human (for util::random::HumanContext)
+  inline util::random::Streams& rngStreams(){ return m_rng; }
+  /// Unique identifier; humans are born in order of identifier
+  inline uint64_t getID() const{ return m_rng.id; }
   //@}
   
   //! Summarize the state of a human individual.
@@ -163,6 +174,10 @@ public:
       return monitoringAgeGroup;
   }
   
+  /** Recompute the monitoring age group, as of the last update, for the
+   * current age groups. Used after loading a warm-up snapshot. */
+  void resetMonAgeGroup();
+  
   inline interventions::PerHumanVaccine& getVaccine(){ return _vaccine; }
   inline const interventions::PerHumanVaccine& getVaccine() const{ return _vaccine; }
   
@@ -212,25 +227,24 @@ private:
   uint32_t m_cohortSet;
   //@}
   
-  /// The next continuous distribution in the series
-  uint32_t nextCtsDist;
-  
-  //TODO(optimisation): it might be better to instead store for each
-  // ComponentId of interest the set of humans who are members
-  typedef std::map<interventions::ComponentId,SimTime> SubPopT;
   /** This lists sub-populations of which the human is a member together with
-   * expiry time.
+   * expiry time. Members of a sub-population across the whole population are
+   * found with Population::subPopMembers.
    * 
-   * Definition: a human is in sub-population p if m_subPopExp.contains(p) and,
-   * for t=m_subPopExp[p], t > sim::now() (at the time of intervention
+   * Definition: a human is in sub-population p if m_subPops has an entry for
+   * p and, for t=m_subPops.expiry(p), t > sim::now() (at the time of intervention
    * deployment) or t > sim::ts0() (equiv t >= sim::ts1()) during human update.
    * 
    * NOTE: this discrepancy is because intervention deployment effectively
    * happens at the end of a time step and we want a duration of 1 time step to
    * mean 1 intervention deployment (that where the human becomes a member) and
    * 1 human update (the next). */
-  SubPopT m_subPopExp;
+  SubPopMembership m_subPops;
+  
+  /// Random number streams (used with the counter-based generator only)
+  util::random::Streams m_rng;
   
+  friend class SubPopMembership;
   friend class ::UnittestUtil;
 };
 
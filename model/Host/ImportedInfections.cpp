@@ -89,6 +89,7 @@ void ImportedInfections::import( Population& population ){
     double rateNow = rate[lastIndex].value;
     if( rateNow > 0.0 ){
         for(Population::Iter it = population.begin(); it!=population.end(); ++it){
+            util::random::HumanContext rngContext( it->rngStreams(), util::random::PURPOSE_DEPLOY );
             if(util::random::bernoulli( rateNow )){
                 it->addInfection();
             }
@@ -27,6 +27,7 @@
 #include "util/ModelOptions.h"
 #include "util/random.h"
 #include "util/errors.h"
+#include "util/parallel.h"
 
 #include <stdexcept>
 #include <cmath>
@@ -241,7 +242,7 @@ int InfectionIncidenceModel::numNewInfections (const Human& human, double effect
         n = WithinHost::WHInterface::MAX_INFECTIONS;
     }
     mon::reportEventMHI( mon::MHR_NEW_INFECTIONS, human, n );
-    ctsNewInfections += n;
+    util::parallel::atomicAdd( ctsNewInfections, n );
     return n;
   }
   if ( (boost::math::isnan)(expectedNumInfections) ){	// check for not-a-number
@@ -23,6 +23,7 @@
 
 #include "Global.h"
 #include "Transmission/PerHost.h"
+#include "util/SlabPool.h"
 
 namespace OM {
     class Parameters;
@@ -75,6 +76,14 @@ protected:
 public:
   virtual ~InfectionIncidenceModel() {}
   
+  /// Instances are allocated from slabs, one pool per derived type
+  static void* operator new( size_t size ){
+      return util::slab::allocate( size );
+  }
+  static void operator delete( void* p, size_t size ){
+      util::slab::deallocate( p, size );
+  }
+  
   /** Return an availability multiplier, dependant on the model (NegBinomMAII
    * and LogNormalMAII models use this). Ideally availability adjustments
    * should have nothing to do with the InfectionIncidenceModel though.
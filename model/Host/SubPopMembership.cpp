@@ -0,0 +1,177 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "Host/SubPopMembership.h"
+#include "Host/Human.h"
+#include "util/checkpoint.h"
+#include "util/parallel.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace OM { namespace Host {
+
+namespace {
+    /// Number of components; slot arrays are allocated at this size
+    size_t numComponents = 0;
+    /// Per component, humans which may have an entry (unordered)
+    std::vector<std::vector<Human*> > indexLists;
+
+    /// Orders humans by identifier, which is population order
+    struct ByID {
+        bool operator()( const Human* a, const Human* b ) const{
+            return a->getID() < b->getID();
+        }
+    };
+}
+
+void SubPopMembership::init( size_t n ){
+    numComponents = n;
+    indexLists.assign( n, std::vector<Human*>() );
+}
+
+size_t SubPopMembership::next( size_t i ) const{
+    if( m_active == 0 ) return m_slots.size();
+    for( ; i < m_slots.size(); ++i ){
+        if( (m_active & summaryBit( i )) && m_slots[i].expiry != sim::never() )
+            return i;
+    }
+    return m_slots.size();
+}
+
+void SubPopMembership::reserve( ComponentId id ){
+    if( id.id < m_slots.size() ) return;
+    m_slots.resize( std::max( numComponents, id.id + 1 ) );
+}
+
+void SubPopMembership::set( ComponentId id, SimTime expiry, Human& owner ){
+    reserve( id );
+    Slot& slot = m_slots[id.id];
+    slot.expiry = expiry;
+    m_active |= summaryBit( id.id );
+    if( slot.listPos == NOT_LISTED && id.id < indexLists.size() ){
+        if( util::parallel::active() ){
+            slot.listPos = PENDING;
+            m_pending = true;
+        }else{
+            listAt( id.id, owner );
+        }
+    }
+}
+
+void SubPopMembership::erase( ComponentId id ){
+    if( id.id >= m_slots.size() ) return;
+    m_slots[id.id].expiry = sim::never();
+    // clear the summary bit unless another entry shares it
+    for( size_t i = id.id % 64; i < m_slots.size(); i += 64 ){
+        if( m_slots[i].expiry != sim::never() ) return;
+    }
+    m_active &= ~summaryBit( id.id );
+}
+
+void SubPopMembership::listAt( size_t id, Human& owner ){
+    std::vector<Human*>& list = indexLists[id];
+    m_slots[id].listPos = static_cast<uint32_t>( list.size() );
+    list.push_back( &owner );
+    m_listed = true;
+}
+
+void SubPopMembership::removeFromList( size_t id, uint32_t pos ){
+    std::vector<Human*>& list = indexLists[id];
+    assert( pos < list.size() );
+    Human* moved = list.back();
+    list[pos] = moved;
+    moved->m_subPops.m_slots[id].listPos = pos;
+    list.pop_back();
+}
+
+void SubPopMembership::listPending( Human& human ){
+    SubPopMembership& self = human.m_subPops;
+    if( !self.m_pending ) return;
+    for( size_t i = 0; i < self.m_slots.size(); ++i ){
+        if( self.m_slots[i].listPos == PENDING )
+            self.listAt( i, human );
+    }
+    self.m_pending = false;
+}
+
+void SubPopMembership::unlist( Human& human ){
+    SubPopMembership& self = human.m_subPops;
+    if( !self.m_listed && !self.m_pending ) return;
+    for( size_t i = 0; i < self.m_slots.size(); ++i ){
+        Slot& slot = self.m_slots[i];
+        if( slot.listPos < PENDING ) removeFromList( i, slot.listPos );
+        slot.listPos = NOT_LISTED;
+    }
+    self.m_listed = false;
+    self.m_pending = false;
+}
+
+void SubPopMembership::members( ComponentId id, std::vector<Human*>& members ){
+    members.clear();
+    if( id.id >= indexLists.size() ) return;
+    std::vector<Human*>& list = indexLists[id.id];
+    for( size_t pos = 0; pos < list.size(); ){
+        Human* human = list[pos];
+        Slot& slot = human->m_subPops.m_slots[id.id];
+        if( slot.expiry == sim::never() ){
+            // entry was removed: drop from the list (another human moves to pos)
+            removeFromList( id.id, pos );
+            slot.listPos = NOT_LISTED;
+            continue;
+        }
+        if( human->isInSubPop( id ) ) members.push_back( human );
+        ++pos;
+    }
+    std::sort( members.begin(), members.end(), ByID() );
+}
+
+void SubPopMembership::operator& (ostream& stream) const{
+    size_t n = 0;
+    for( size_t i = next( 0 ); i < end(); i = next( i + 1 ) ) ++n;
+    n & stream;
+    for( size_t i = next( 0 ); i < end(); i = next( i + 1 ) ){
+        ComponentId( i ) & stream;
+        m_slots[i].expiry.raw() & stream;
+    }
+}
+void SubPopMembership::operator& (istream& stream){
+    size_t n;
+    n & stream;
+    util::checkpoint::validateListSize( n );
+    m_slots.clear();
+    m_active = 0;
+    m_listed = false;
+    m_pending = false;
+    for( size_t i = 0; i < n; ++i ){
+        ComponentId id( stream );
+        SimTime expiry;
+        expiry & stream;
+        reserve( id );
+        m_slots[id.id].expiry = expiry;
+        m_active |= summaryBit( id.id );
+        if( id.id < indexLists.size() ){
+            m_slots[id.id].listPos = PENDING;
+            m_pending = true;
+        }
+    }
+}
+
+} }
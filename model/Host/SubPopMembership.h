@@ -0,0 +1,124 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_Host_SubPopMembership
+#define Hmod_Host_SubPopMembership
+
+#include "Global.h"
+#include "interventions/Interfaces.hpp"
+#include <vector>
+
+class UnittestUtil;
+
+namespace OM { namespace Host {
+    class Human;
+    using interventions::ComponentId;
+
+/** The sub-populations of which one human is a member, with expiry dates
+ * (see Human::isInSubPop), plus an index of members of each sub-population
+ * across the whole population.
+ *
+ * Component identifiers are small dense integers fixed by
+ * InterventionManager::init, so entries are stored in an array indexed by
+ * identifier, allocated when the human first joins a sub-population. A 64-bit
+ * summary has bit (id mod 64) set while there is an entry for some such id;
+ * most humans are in no sub-population and checking them costs one test.
+ *
+ * The index lists, per component, humans which have (or recently had) an
+ * entry. Entries removed during a human update are only dropped from the
+ * lists when next read. Humans joining during a partitioned update (see
+ * util::parallel) are marked pending and listed by Population afterwards,
+ * so that the lists are only modified from one thread. */
+class SubPopMembership {
+public:
+    SubPopMembership() : m_active(0), m_pending(false), m_listed(false) {}
+
+    /** Set the number of human intervention components and enable the index.
+     * Called by InterventionManager::init. */
+    static void init( size_t numComponents );
+
+    /// Expiry date of membership of id, or sim::never() if there is no entry
+    inline SimTime expiry( ComponentId id ) const{
+        return id.id < m_slots.size() ? m_slots[id.id].expiry : sim::never();
+    }
+
+    /** Index of the first entry at or after i (iterate with
+     * i = next(i + 1)), or end() if there are no more. */
+    size_t next( size_t i ) const;
+    inline size_t end() const{ return m_slots.size(); }
+
+    /** Add or update the entry for id. owner is the human owning this object;
+     * it is added to the index if not already listed. */
+    void set( ComponentId id, SimTime expiry, Human& owner );
+
+    /// Remove the entry for id, if any
+    void erase( ComponentId id );
+
+    ///@brief Population-level index
+    //@{
+    /** List human in the index for entries added during a partitioned update
+     * or loaded from a checkpoint. Must be called outside of a partitioned
+     * update. */
+    static void listPending( Human& human );
+
+    /// Remove human from the index (before it is destroyed).
+    static void unlist( Human& human );
+
+    /** Set members to the humans currently in sub-population id (see
+     * Human::isInSubPop), in population order. Must be called outside of a
+     * partitioned update. */
+    static void members( ComponentId id, std::vector<Human*>& members );
+    //@}
+
+    /// Checkpointing (same format as the map used previously)
+    void operator& (istream& stream);
+    void operator& (ostream& stream) const;
+
+private:
+    /// Position of a human in the index list for one component
+    enum { NOT_LISTED = 0xFFFFFFFF, PENDING = 0xFFFFFFFE };
+
+    struct Slot {
+        Slot() : listPos(NOT_LISTED) {}
+        SimTime expiry;     // sim::never() if no entry
+        uint32_t listPos;   // position in index list, NOT_LISTED or PENDING
+    };
+
+    /// Make sure the slot for id exists
+    void reserve( ComponentId id );
+    /// Add owner to the index list for id (slot must exist)
+    void listAt( size_t id, Human& owner );
+    /// Remove the human at position pos from the index list for id
+    static void removeFromList( size_t id, uint32_t pos );
+
+    static inline uint64_t summaryBit( size_t id ){
+        return static_cast<uint64_t>(1) << (id % 64);
+    }
+
+    std::vector<Slot> m_slots;
+    uint64_t m_active;  // summary of which slots have entries
+    bool m_pending;     // some slot is PENDING
+    bool m_listed;      // some slot may be listed
+
+    friend class ::UnittestUtil;
+};
+
+} }
+#endif
@@ -22,6 +22,8 @@
 #include "util/errors.h"
 #include "util/StreamValidator.h"
 #include "util/vectors.h"
+#include "util/parallel.h"
+#include "util/Quadrature.h"
 
 #include <gsl/gsl_integration.h>
 #include <limits>
@@ -88,12 +90,12 @@ struct Params_convFactor {
     double KnP, KnM;      // IC50^n: (mg/kg) ^ n
 };
 
-double calculateParentQuantity( struct Params_convFactor p, double qtyG, double qtyP, double expAbsorb, double expPLoss ) {
+double calculateParentQuantity( const Params_convFactor& p, double qtyG, double qtyP, double expAbsorb, double expPLoss ) {
     return p.f * qtyG * expAbsorb
         + (qtyP - p.f * qtyG) * expPLoss;
 }
 
-double calculateParentDrugFactor( struct Params_convFactor p, double expAbsorb, double expPLoss ) {
+double calculateParentDrugFactor( const Params_convFactor& p, double expAbsorb, double expPLoss ) {
     const double qtyP = calculateParentQuantity(p, p.qtyG, p.qtyP, expAbsorb, expPLoss);
     const double cP = qtyP * p.invVdP;                  // concentrations; mg/l*/
     const double cnP = pow(cP, p.nP);                   // (mg/l) ^ n
@@ -101,13 +103,13 @@ double calculateParentDrugFactor( struct Params_convFactor p, double expAbsorb,
     return fCP;
 }
 
-double calculateMetaboliteQuantity(struct Params_convFactor p, double qtyG, double qtyP, double qtyM, double expAbsorb, double expPLoss, double t) {
+double calculateMetaboliteQuantity( const Params_convFactor& p, double qtyG, double qtyP, double qtyM, double expAbsorb, double expPLoss, double t) {
     return p.g * qtyG * expAbsorb
         + (p.h * qtyG - p.i * qtyP) * expPLoss
         + (p.j * qtyG - p.i * qtyP + qtyM) * exp(p.nkM * t);
 }
 
-double calculateMetaboliteDrugFactor( struct Params_convFactor p, double expAbsorb, double expPLoss, double t ) {
+double calculateMetaboliteDrugFactor( const Params_convFactor& p, double expAbsorb, double expPLoss, double t ) {
     const double qtyM = calculateMetaboliteQuantity(p, p.qtyG, p.qtyP, p.qtyM, expAbsorb, expPLoss, t);
     const double cM = qtyM * p.invVdM;              // concentrations; mg/l
     const double cnM = pow(cM, p.nM);               // (mg/l) ^ n
@@ -122,38 +124,54 @@ double calculateMetaboliteDrugFactor( struct Params_convFactor p, double expAbso
  * 
  * @param t The variable being integrated over (in this case, time since start
  *      of day or last dose, units days)
- * @param pp Pointer to a Params_convFactor struct
+ * @param p Parameters
  * @return killing rate (unitless)
  */
-double func_convFactor( double t, void* pp ){
-    const Params_convFactor& p = *static_cast<const Params_convFactor*>( pp );
+inline double killingRate_conv( double t, const Params_convFactor& p ){
     const double expAbsorb = exp(p.nka * t), expPLoss = exp(p.nl * t);
     const double fCP = calculateParentDrugFactor( p, expAbsorb, expPLoss );
     const double fCM = calculateMetaboliteDrugFactor( p, expAbsorb, expPLoss, t );
     // use the most effective killing factor (from area under the drug kill curve), which is the one with the bigger number
     return max(fCP,fCM);
 }
+/// killingRate_conv as a gsl_function; pp points to a Params_convFactor struct
+double func_convFactor( double t, void* pp ){
+    return killingRate_conv( t, *static_cast<const Params_convFactor*>( pp ) );
+}
+/// killingRate_conv as a function object, for util::quadrature
+struct Func_convFactor {
+    explicit Func_convFactor( const Params_convFactor& params ) : p(params) {}
+    double operator()( double t ) const{ return killingRate_conv( t, p ); }
+    const Params_convFactor& p;
+};
 
 const size_t GSL_INTG_CONV_MAX_ITER = 1000;     // 10 seems enough, but no harm in using a higher value
-gsl_integration_workspace *gsl_intgr_conv_wksp = gsl_integration_workspace_alloc (GSL_INTG_CONV_MAX_ITER);
+// One workspace per partition of a multi-threaded update, allocated on first use.
+gsl_integration_workspace *gsl_intgr_conv_wksp[util::parallel::MAX_THREADS] = { 0 };
 //NOTE: we "should" free, but mem-leaks at end of program aren't really important
-// gsl_integration_workspace_free (gsl_intgr_conv_wksp);
+// gsl_integration_workspace_free (gsl_intgr_conv_wksp[i]);
 double LSTMDrugConversion::calculateFactor(const Params_convFactor& p, double duration) const{
-    gsl_function F;
-    F.function = &func_convFactor;
-    // gsl_function doesn't accept const; we re-apply const later
-    F.params = static_cast<void*>(const_cast<Params_convFactor*>(&p));
-    
     // NOTE: tolerances are arbitrary, but seem to be sufficient
     const double abs_eps = 1e-3, rel_eps = 1e-3;
-    // NOTE: 1 through 6 are different algorithms of increasing complexity
-    const int qag_rule = 1;     // alg 1 seems to be good enough
     double intfC, err_eps;      // intfC will carry our result; err_eps is a measure of accuracy of the result
     
-    int r = gsl_integration_qag (&F, 0.0, duration, abs_eps, rel_eps,
-                                 GSL_INTG_CONV_MAX_ITER, qag_rule, gsl_intgr_conv_wksp, &intfC, &err_eps);
-    if( r != 0 ){
-        throw TRACED_EXCEPTION( "calculateFactor: error from gsl_integration_qag",util::Error::GSL );
+    // As in LSTMDrugThreeComp: try a single Gauss-Kronrod step first
+    if( !util::quadrature::fixedOrder( Func_convFactor(p), 0.0, duration, abs_eps, rel_eps, intfC, err_eps ) ){
+        gsl_function F;
+        F.function = &func_convFactor;
+        // gsl_function doesn't accept const; we re-apply const later
+        F.params = static_cast<void*>(const_cast<Params_convFactor*>(&p));
+        
+        // NOTE: 1 through 6 are different algorithms of increasing complexity
+        const int qag_rule = 1;     // alg 1 seems to be good enough
+        
+        gsl_integration_workspace *&wksp = gsl_intgr_conv_wksp[util::parallel::partition()];
+        if( wksp == 0 ) wksp = gsl_integration_workspace_alloc (GSL_INTG_CONV_MAX_ITER);
+        int r = gsl_integration_qag (&F, 0.0, duration, abs_eps, rel_eps,
+                                     GSL_INTG_CONV_MAX_ITER, qag_rule, wksp, &intfC, &err_eps);
+        if( r != 0 ){
+            throw TRACED_EXCEPTION( "calculateFactor: error from gsl_integration_qag",util::Error::GSL );
+        }
     }
     if( err_eps > 5e-2 ){
         // This could be a warning, except that warnings tend to be ignored.
@@ -21,6 +21,8 @@
 #include "PkPd/Drug/LSTMDrugThreeComp.h"
 #include "util/errors.h"
 #include "util/StreamValidator.h"
+#include "util/parallel.h"
+#include "util/Quadrature.h"
 
 #include <boost/math/constants/constants.hpp>
 #include <gsl/gsl_integration.h>
@@ -111,12 +113,10 @@ struct Params_fC {
  * 
  * @param t The variable being integrated over (in this case, time since start
  *      of day or last dose, units days)
- * @param pp Pointer to a Params_fC struct
+ * @param p Parameters
  * @return killing rate (unitless)
  */
-double func_fC( double t, void* pp ){
-    const Params_fC& p = *static_cast<const Params_fC*>( pp );
-    
+inline double killingRate_fC( double t, const Params_fC& p ){
     // exponential decay of drug concentration:
     const double concA = p.cA * exp(p.na * t);
     const double concB = p.cB * exp(p.nb * t);
@@ -128,26 +128,44 @@ double func_fC( double t, void* pp ){
     const double fC = p.V * cn / (cn + p.Kn);       // unitless
     return fC;
 }
+/// killingRate_fC as a gsl_function; pp points to a Params_fC struct
+double func_fC( double t, void* pp ){
+    return killingRate_fC( t, *static_cast<const Params_fC*>( pp ) );
+}
+/// killingRate_fC as a function object, for util::quadrature
+struct Func_fC {
+    explicit Func_fC( const Params_fC& params ) : p(params) {}
+    double operator()( double t ) const{ return killingRate_fC( t, p ); }
+    const Params_fC& p;
+};
 const size_t GSL_INTG_MAX_ITER = 1000;     // 10 seems enough, but no harm in using a higher value
-gsl_integration_workspace *gsl_intgr_wksp = gsl_integration_workspace_alloc (GSL_INTG_MAX_ITER);
+// One workspace per partition of a multi-threaded update, allocated on first use.
+gsl_integration_workspace *gsl_intgr_wksp[util::parallel::MAX_THREADS] = { 0 };
 //NOTE: we "should" free, but mem-leaks at end of program aren't really important
-// gsl_integration_workspace_free (gsl_intgr_wksp);
+// gsl_integration_workspace_free (gsl_intgr_wksp[i]);
 double LSTMDrugThreeComp::calculateFactor(const Params_fC& p, double duration) const{
-    gsl_function F;
-    F.function = &func_fC;
-    // gsl_function doesn't accept const; we re-apply const later
-    F.params = static_cast<void*>(const_cast<Params_fC*>(&p));
-    
     // NOTE: tolerances are arbitrary, but seem to be sufficient
     const double abs_eps = 1e-2, rel_eps = 1e-2;
-    // NOTE: 1 through 6 are different algorithms of increasing complexity
-    const int qag_rule = 1;     // alg 1 seems to be good enough
     double intfC, err_eps;
     
-    int r = gsl_integration_qag (&F, 0.0, duration, abs_eps, rel_eps,
-                                 GSL_INTG_MAX_ITER, qag_rule, gsl_intgr_wksp, &intfC, &err_eps);
-    if( r != 0 ){
-        throw TRACED_EXCEPTION( "calculateFactor: error from gsl_integration_qag",util::Error::GSL );
+    // Usually a single Gauss-Kronrod step is accurate enough; if not, use
+    // adaptive integration. Either way the result is what QAG would give.
+    if( !util::quadrature::fixedOrder( Func_fC(p), 0.0, duration, abs_eps, rel_eps, intfC, err_eps ) ){
+        gsl_function F;
+        F.function = &func_fC;
+        // gsl_function doesn't accept const; we re-apply const later
+        F.params = static_cast<void*>(const_cast<Params_fC*>(&p));
+        
+        // NOTE: 1 through 6 are different algorithms of increasing complexity
+        const int qag_rule = 1;     // alg 1 seems to be good enough
+        
+        gsl_integration_workspace *&wksp = gsl_intgr_wksp[util::parallel::partition()];
+        if( wksp == 0 ) wksp = gsl_integration_workspace_alloc (GSL_INTG_MAX_ITER);
+        int r = gsl_integration_qag (&F, 0.0, duration, abs_eps, rel_eps,
+                                     GSL_INTG_MAX_ITER, qag_rule, wksp, &intfC, &err_eps);
+        if( r != 0 ){
+            throw TRACED_EXCEPTION( "calculateFactor: error from gsl_integration_qag",util::Error::GSL );
+        }
     }
     if( err_eps > 5e-2 ){
         // This could be a warning, except that warnings tend to be ignored.
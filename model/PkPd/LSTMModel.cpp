@@ -26,6 +26,7 @@
 #include "mon/reporting.h"
 #include "util/checkpoint_containers.h"
 #include "util/errors.h"
+#include "util/timer.h"
 
 #include "schema/scenario.h"
 
@@ -44,6 +45,10 @@ void LSTMModel::init( const scnXml::Scenario& scenario ){
 
 // ———  non-static set up / tear down functions  ———
 
+LSTMModel::LSTMModel() :
+    factorCacheMass( numeric_limits<double>::quiet_NaN() )
+{}
+
 void LSTMModel::checkpoint (istream& stream) {
     size_t numDrugs;	// type must be same as m_drugs.size()
     numDrugs & stream;
@@ -82,7 +87,7 @@ void LSTMModel::medicate(double body_mass){
     if( medicateQueue.empty() ) return;
     
     // Process pending medications (in interal queue) and apply/update:
-    list<MedicateData>::iterator it = medicateQueue.begin();
+    MedicateQueue::iterator it = medicateQueue.begin();
     while( it != medicateQueue.end() ){
         if( it->time < 1.0 ){   // Medicate medications to be prescribed starting at the next time-step
             // This function could be inlined, except for uses in testing:
@@ -96,6 +101,7 @@ void LSTMModel::medicate(double body_mass){
 }
 
 void LSTMModel::medicateDrug(size_t typeIndex, double qty, double time, double bodyMass) {
+    factorCache.clear();
     //TODO: might be a little faster if m_drugs was pre-allocated with a slot for each drug type, using a null pointer
     foreach( LSTMDrug& drug, m_drugs ){
         if (drug.getIndex() == typeIndex){
@@ -128,16 +134,31 @@ double LSTMModel::getDrugConc (size_t drug_index) const{
 
 double LSTMModel::getDrugFactor (uint32_t genotype, double body_mass) const{
     double factor = 1.0; //no effect
+    if( m_drugs.empty() ) return factor;
     
+    if( body_mass != factorCacheMass ){
+        factorCache.clear();
+        factorCacheMass = body_mass;
+    }
+    for( vector<pair<uint32_t,double> >::const_iterator it = factorCache.begin(),
+            end = factorCache.end(); it != end; ++it ){
+        if( it->first == genotype ) return it->second;
+    }
+    
+    OM_PROFILE_SCOPE( DRUG_FACTOR );
+    OM_PROFILE_ITEMS( DRUG_FACTOR, m_drugs.size() );
+
     for( DrugVec::const_iterator drug = m_drugs.begin(), end = m_drugs.end();
             drug != end; ++drug ){
         double drugFactor = drug->calculateDrugFactor(genotype, body_mass);
         factor *= drugFactor;
     }
+    factorCache.push_back( make_pair( genotype, factor ) );
     return factor;
 }
 
 void LSTMModel::decayDrugs (double body_mass) {
+    factorCache.clear();
     // Update concentrations for each drug.
     // TODO: previously we removed drugs with negligible concentration here. What now, just set concentration to 0?
     foreach( LSTMDrug& drug, m_drugs ){
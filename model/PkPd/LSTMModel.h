@@ -22,6 +22,7 @@
 #define Hmod_LSTMPkPdModel
 
 #include "PkPd/Drug/LSTMDrug.h"
+#include "util/SlabPool.h"
 
 #include <boost/ptr_container/ptr_vector.hpp>
 
@@ -82,6 +83,8 @@ private:
  */
 class LSTMModel {
 public:
+    LSTMModel();
+    
     /// Static initialisation
     static void init ( const scnXml::Scenario& scenario );
     
@@ -122,13 +125,19 @@ public:
      *
      * Each time step, on each infection, the parasite density is multiplied by
      * the return value of this infection. The WithinHostModels are responsible
-     * for clearing infections once the parasite density is negligible. */
+     * for clearing infections once the parasite density is negligible.
+     * 
+     * The factor depends only on the genotype and drugs in the body, so it
+     * is cached and only calculated once per genotype each day, however many
+     * infections the host carries. */
     double getDrugFactor (uint32_t genotype, double body_mass) const;
     
     /** After any resident infections have been reduced by getDrugFactor(),
      * this function is called to update drug levels to their effective level
      * at the end of the day, as well as clear data once drug concentrations
-     * become negligible. */
+     * become negligible.
+     * 
+     * Invalidates cached drug factors, as does medicate(). */
     void decayDrugs (double body_mass);
     
     /** Make summaries of drug concentration data. */
@@ -160,7 +169,17 @@ private:
     DrugVec m_drugs;
     
     /// All pending medications
-    list<MedicateData> medicateQueue;
+    typedef list<MedicateData, util::SlabAllocator<MedicateData> > MedicateQueue;
+    MedicateQueue medicateQueue;
+    
+    /** Drug factors calculated by getDrugFactor() since drugs were last
+     * changed, as (genotype, factor) pairs. Few genotypes are usually
+     * present, so a linear search is fine.
+     * 
+     * Not checkpointed: it is cleared at the end of each update. */
+    mutable vector<pair<uint32_t,double> > factorCache;
+    /// Body mass used for factorCache
+    mutable double factorCacheMass;
     
     friend class ::UnittestUtil;
 };
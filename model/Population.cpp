@@ -35,9 +35,13 @@
 #include "util/random.h"
 #include "util/ModelOptions.h"
 #include "util/StreamValidator.h"
+#include "util/parallel.h"
+#include "util/timer.h"
+#include "mon/management.h"
 #include <schema/scenario.h>
 
 #include <cmath>
+#include <algorithm>
 #include <boost/format.hpp>
 #include <boost/assign.hpp>
 
@@ -75,7 +79,8 @@ void Population::staticCheckpoint (ostream& stream)
 // -----  non-static methods: creation/destruction, checkpointing  -----
 
 Population::Population(const scnXml::Entomology& entoData, size_t populationSize)
-    : populationSize (populationSize), recentBirths(0)
+    : populationSize (populationSize), nextHumanId(0), recentBirths(0),
+    humanPool (sizeof(Host::Human), 256)
 {
     using Monitoring::Continuous;
     Continuous.registerCallback( "hosts", "\thosts", MakeDelegate( this, &Population::ctsHosts ) );
@@ -113,12 +118,13 @@ Population::Population(const scnXml::Entomology& entoData, size_t populationSize
 //         MakeDelegate( this, &Population::ctsNetHoleIndex ) );
     
     _transmissionModel = Transmission::TransmissionModel::createTransmissionModel(entoData, populationSize);
+    population.reserve( populationSize );
 }
 
 Population::~Population()
 {
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        iter->destroy();
+    for(HumanPop::iterator it = population.begin(); it != population.end(); ++it) {
+        freeHuman( *it );
     }
     delete _transmissionModel;
 }
@@ -131,10 +137,8 @@ void Population::checkpoint (istream& stream)
         throw util::checkpoint_error(
             (boost::format("pop size (%1%) exceeds that given in scenario.xml") %popSize).str() );
     for(size_t i = 0; i < popSize && !stream.eof(); ++i) {
-        // Note: calling this constructor of Host::Human is slightly wasteful, but avoids the need for another
-        // ctor and leaves less opportunity for uninitialized memory.
-        population.push_back( new Host::Human (*_transmissionModel, sim::zero()) );
-        population.back() & stream;
+        population.push_back( allocHuman( stream ) );
+        Host::SubPopMembership::listPending( *population.back() );
     }
     if (population.size() != popSize)
         throw util::checkpoint_error(
@@ -143,7 +147,7 @@ void Population::checkpoint (istream& stream)
 void Population::checkpoint (ostream& stream)
 {
     population.size() & stream;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter)
+    for(Iter iter = begin(); iter != end(); ++iter)
         (*iter) & stream;
 }
 
@@ -155,6 +159,13 @@ void Population::preMainSimInit ()
     recentBirths = 0;
 }
 
+void Population::resetMonitoring ()
+{
+    for(Iter iter = begin(); iter != end(); ++iter)
+        iter->resetMonAgeGroup();
+    _transmissionModel->resetSurveyInoculations();
+}
+
 void Population::createInitialHumans ()
 {
     /* We create a whole population here, regardless of whether humans can
@@ -180,14 +191,84 @@ void Population::createInitialHumans ()
 }
 
 
+namespace {
+    /// Orders humans before an age: true while the human is at least that old
+    struct AgeAtLeast {
+        explicit AgeAtLeast( SimTime now ) : now(now) {}
+        bool operator()( const Host::Human* human, SimTime age ) const{
+            return human->age( now ) >= age;
+        }
+        SimTime now;
+    };
+    /// As AgeAtLeast, with the age in years
+    struct AgeYearsAtLeast {
+        explicit AgeYearsAtLeast( SimTime now ) : now(now) {}
+        bool operator()( const Host::Human* human, double years ) const{
+            return !(human->age( now ).inYears() < years);
+        }
+        SimTime now;
+    };
+}
+
+void Population::ageRange( SimTime minAge, SimTime maxAge, Iter& first, Iter& last ){
+    // Ages are non-increasing through the list, so humans at least a given
+    // age form a prefix.
+    AgeAtLeast atLeast( sim::now() );
+    HumanPop::iterator lo = std::lower_bound( population.begin(), population.end(), maxAge, atLeast );
+    HumanPop::iterator hi = std::lower_bound( lo, population.end(), minAge, atLeast );
+    first = Iter( lo );
+    last = Iter( hi );
+}
+
+void Population::subPopMembers( interventions::ComponentId id, SimTime minAge,
+        SimTime maxAge, HumanPop& members )
+{
+    Host::SubPopMembership::members( id, members );
+    // Members are in population order, so remove those outside the age range
+    // by compacting in place.
+    const SimTime now = sim::now();
+    size_t nKept = 0;
+    for( size_t i = 0; i < members.size(); ++i ){
+        SimTime age = members[i]->age( now );
+        if( age >= minAge && age < maxAge ) members[nKept++] = members[i];
+    }
+    members.resize( nKept );
+}
+
+
 // -----  non-static methods: simulation loop  -----
 
 void Population::newHuman( SimTime dob ){
     util::streamValidate( dob.raw() );
-    population.push_back( new Host::Human (*_transmissionModel, dob) );
+    population.push_back( allocHuman( dob, nextHumanId ) );
+    ++nextHumanId;
     ++recentBirths;
 }
 
+Host::Human* Population::allocHuman( SimTime dob, uint64_t id ){
+    void* mem = humanPool.allocate();
+    try{
+        return new (mem) Host::Human (*_transmissionModel, dob, id);
+    }catch(...){
+        humanPool.deallocate( mem );
+        throw;
+    }
+}
+Host::Human* Population::allocHuman( istream& stream ){
+    void* mem = humanPool.allocate();
+    try{
+        return new (mem) Host::Human (stream);
+    }catch(...){
+        humanPool.deallocate( mem );
+        throw;
+    }
+}
+void Population::freeHuman( Host::Human* human ){
+    human->destroy();
+    human->~Human();
+    humanPool.deallocate( human );
+}
+
 void Population::update1( SimTime firstVecInitTS ){
     // This should only use humans being updated: otherwise too small a proportion
     // will be infected. However, we don't have another number to use instead.
@@ -197,7 +278,10 @@ void Population::update1( SimTime firstVecInitTS ){
     
     // This should be called before humans contract new infections in the simulation step.
     // This needs the whole population (it is an approximation before all humans are updated).
-    _transmissionModel->vectorUpdate (*this);
+    {
+        OM_PROFILE_SCOPE( VECTOR_UPDATE );
+        _transmissionModel->vectorUpdate (*this);
+    }
 
     //NOTE: other parts of code are not set up to handle changing population size. Also
     // populationSize is assumed to be the _actual and exact_ population size by other code.
@@ -205,22 +289,35 @@ void Population::update1( SimTime firstVecInitTS ){
     //int targetPop = (int) (populationSize * exp( AgeStructure::rho * sim::ts1().inSteps() ));
     int targetPop = populationSize;
     int cumPop = 0;
+    if( ctsStats.wanted ) ctsStats.clear();
+    
+    // With several threads, all humans are updated first; removal below then
+    // uses the stored results. Otherwise humans are updated in the loop.
+    vector<char> partitionedIsDead;
+    if( util::parallel::numThreads() > 1 )
+        updatePartitioned( firstVecInitTS, partitionedIsDead );
 
     // Update each human in turn
     //std::cout<<" time " <<t<<std::endl;
-    Iter last = population.end();
-    --last;
-    for(Iter iter = population.begin(); iter != population.end();) {
-        // Update human, and remove if too old.
-        // We only need to update humans who will survive past the end of the
-        // "one life span" init phase (this is an optimisation). lastPossibleTS
-        // is the time step they die at (some code still runs on this step).
-        SimTime lastPossibleTS = iter->getDateOfBirth() + sim::maxHumanAge();   // this is last time of possible update
-        bool updateHuman = lastPossibleTS >= firstVecInitTS;
-        bool isDead = iter->update(_transmissionModel, updateHuman);
+    // Survivors are moved down over removed humans (keeping order), so the
+    // list is compacted in the same pass.
+    size_t nKept = 0;
+    for(size_t i = 0, n = population.size(); i < n; ++i) {
+        Host::Human* human = population[i];
+        bool isDead;
+        if( partitionedIsDead.empty() ){
+            // Update human, and remove if too old.
+            // We only need to update humans who will survive past the end of the
+            // "one life span" init phase (this is an optimisation). lastPossibleTS
+            // is the time step they die at (some code still runs on this step).
+            SimTime lastPossibleTS = human->getDateOfBirth() + sim::maxHumanAge();   // this is last time of possible update
+            bool updateHuman = lastPossibleTS >= firstVecInitTS;
+            isDead = human->update(_transmissionModel, updateHuman);
+        }else{
+            isDead = partitionedIsDead[i];
+        }
         if( isDead ){
-            iter->destroy();
-            iter = population.erase (iter);
+            freeHuman( human );
             continue;
         }
         
@@ -231,15 +328,20 @@ void Population::update1( SimTime firstVecInitTS ){
         // "outmigrate" some to maintain population shape
         //NOTE: better to use age(sim::ts0())? Possibly, but the difference will not be very significant.
         // Also see targetPop = ... comment above
-        if( cumPop > AgeStructure::targetCumPop(iter->age(sim::ts1()).inSteps(), targetPop) ){
+        if( cumPop > AgeStructure::targetCumPop(human->age(sim::ts1()).inSteps(), targetPop) ){
             --cumPop;
-            iter->destroy();
-            iter = population.erase (iter);
+            freeHuman( human );
             continue;
         }
         //END Population size & age structure
-        ++iter;
+        // sub-populations joined during a partitioned update
+        if( !partitionedIsDead.empty() )
+            Host::SubPopMembership::listPending( *human );
+        if( ctsStats.wanted ) ctsStats.add( *human );
+        population[nKept] = human;
+        ++nKept;
     } // end of per-human updates
+    population.resize( nKept );
 
     // increase population size to targetPop
     while (cumPop < targetPop) {
@@ -247,12 +349,72 @@ void Population::update1( SimTime firstVecInitTS ){
         //++nCounter;
         ++cumPop;
     }
+    if( ctsStats.wanted ){
+        for( size_t i = nKept; i < population.size(); ++i )
+            ctsStats.add( *population[i] );
+        ctsStats.time = sim::ts1();     // i.e. sim::now() during the next step
+    }
     
     // Doesn't matter whether non-updated humans are included (value isn't used
     // before all humans are updated).
     _transmissionModel->update (*this);
 }
 
+void Population::updatePartitioned( SimTime firstVecInitTS, vector<char>& isDead ){
+    const size_t nParts = util::parallel::numThreads();
+    isDead.assign( population.size(), false );
+    
+    // Partition boundaries: the first nLong partitions get one extra human
+    vector<size_t> partOffset( nParts + 1 );
+    const size_t nPerPart = population.size() / nParts;
+    const size_t nLong = population.size() % nParts;
+    size_t offset = 0;
+    for( size_t k = 0; k < nParts; ++k ){
+        partOffset[k] = offset;
+        offset += nPerPart + (k < nLong ? 1 : 0);
+    }
+    partOffset[nParts] = offset;
+    
+    // Exceptions may not leave a parallel region, so we pass them out.
+    vector<char> failed( nParts, false );
+    vector<string> errMsg( nParts );
+    vector<int> errCode( nParts, util::Error::Default );
+    
+    util::parallel::setActive( true );
+    const int nPartsI = static_cast<int>(nParts);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nPartsI) schedule(static, 1)
+#endif
+    for( int k = 0; k < nPartsI; ++k ){
+        util::parallel::enterPartition( k );
+        try{
+            for( size_t i = partOffset[k]; i < partOffset[k+1]; ++i ){
+                Host::Human* human = population[i];
+                // See update1 for the meaning of this:
+                SimTime lastPossibleTS = human->getDateOfBirth() + sim::maxHumanAge();
+                isDead[i] = human->update(_transmissionModel, lastPossibleTS >= firstVecInitTS);
+            }
+        }catch( const util::base_exception& e ){
+            failed[k] = true;
+            errMsg[k] = e.message();
+            errCode[k] = e.getCode();
+        }catch( const std::exception& e ){
+            failed[k] = true;
+            errMsg[k] = e.what();
+        }
+        util::parallel::enterPartition( 0 );
+    }
+    util::parallel::setActive( false );
+    
+    // Merge in partition order, which is the order a serial update uses
+    mon::mergePartitionReports();
+    _transmissionModel->mergePartitions();
+    
+    for( size_t k = 0; k < nParts; ++k ){
+        if( failed[k] ) throw util::base_exception( errMsg[k], errCode[k] );
+    }
+}
+
 
 // -----  non-static methods: reporting  -----
 
@@ -261,14 +423,13 @@ void Population::ctsHosts (ostream& stream){
     stream << '\t' << population.size();
 }
 void Population::ctsHostDemography (ostream& stream){
-    Population::ConstReverseIter it = population.crbegin();
-    int cumCount = 0;
+    // Ages are non-increasing through the list, so humans younger than each
+    // bound form a suffix, found by binary search.
+    AgeYearsAtLeast atLeast( sim::now() );
     foreach( double ubound, ctsDemogAgeGroups ){
-        while( it != population.crend() && it->age(sim::now()).inYears() < ubound ){
-            ++cumCount;
-            ++it;
-        }
-        stream << '\t' << cumCount;
+        HumanPop::const_iterator it = std::lower_bound( population.begin(),
+                population.end(), ubound, atLeast );
+        stream << '\t' << static_cast<int>( population.end() - it );
     }
 }
 void Population::ctsRecentBirths (ostream& stream){
@@ -276,49 +437,54 @@ void Population::ctsRecentBirths (ostream& stream){
     recentBirths = 0;
 }
 void Population::ctsPatentHosts (ostream& stream){
-    int patent = 0;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        if( iter->getWithinHostModel().diagnosticResult(WithinHost::diagnostics::monitoringDiagnostic()) )
-            ++patent;
+    updateCtsStats();
+    int patent = ctsStats.nPatent;
+    if( patent < 0 ){
+        patent = 0;
+        for(Iter iter = begin(); iter != end(); ++iter) {
+            if( iter->getWithinHostModel().diagnosticResult(WithinHost::diagnostics::monitoringDiagnostic()) )
+                ++patent;
+        }
     }
     stream << '\t' << patent;
 }
 void Population::ctsImmunityh (ostream& stream){
-    double x = 0.0;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        x += iter->getWithinHostModel().getCumulative_h();
-    }
+    updateCtsStats();
+    double x = ctsStats.sumh;
     x /= populationSize;
     stream << '\t' << x;
 }
 void Population::ctsImmunityY (ostream& stream){
-    double x = 0.0;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        x += iter->getWithinHostModel().getCumulative_Y();
-    }
+    updateCtsStats();
+    double x = ctsStats.sumY;
     x /= populationSize;
     stream << '\t' << x;
 }
 void Population::ctsMedianImmunityY (ostream& stream){
-    vector<double> list;
-    list.reserve( populationSize );
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        list.push_back( iter->getWithinHostModel().getCumulative_Y() );
+    if( !ctsStats.wantValuesY ){
+        ctsStats.wantValuesY = true;
+        ctsStats.time = sim::never();   // force a scan to gather values
     }
-    sort( list.begin(), list.end() );
+    updateCtsStats();
+    // Select the middle value(s) instead of sorting; the result is the same.
+    // valuesY is reset by the next update.
+    vector<double>& list = ctsStats.valuesY;
+    assert( list.size() == populationSize );
     double x;
+    size_t i = populationSize / 2;
+    nth_element( list.begin(), list.begin() + i, list.end() );
     if( mod_nn(populationSize, 2) == 0 ){
-        size_t i = populationSize / 2;
-        x = (list[i-1]+list[i])/2.0;
+        // list[i-1] of a sorted list is the largest value before i
+        x = (*max_element( list.begin(), list.begin() + i ) + list[i])/2.0;
     }else{
-        x = list[populationSize / 2];
+        x = list[i];
     }
     stream << '\t' << x;
 }
 void Population::ctsMeanAgeAvailEffect (ostream& stream){
     int nHumans = 0;
     double avail = 0.0;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+    for(Iter iter = begin(); iter != end(); ++iter) {
         if( !iter->perHostTransmission.isOutsideTransmission() ){
             ++nHumans;
             avail += iter->perHostTransmission.relativeAvailabilityAge(iter->age(sim::now()).inYears());
@@ -327,33 +493,54 @@ void Population::ctsMeanAgeAvailEffect (ostream& stream){
     stream << '\t' << avail/nHumans;
 }
 void Population::ctsITNCoverage (ostream& stream){
-    int nActive = 0;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        nActive += iter->perHostTransmission.hasActiveInterv( interventions::Component::ITN );
-    }
-    double coverage = static_cast<double>(nActive) / populationSize;
+    updateCtsStats();
+    double coverage = static_cast<double>(ctsStats.nITN) / populationSize;
     stream << '\t' << coverage;
 }
 void Population::ctsIRSCoverage (ostream& stream){
-    int nActive = 0;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        nActive += iter->perHostTransmission.hasActiveInterv( interventions::Component::IRS );
-    }
-    double coverage = static_cast<double>(nActive) / populationSize;
+    updateCtsStats();
+    double coverage = static_cast<double>(ctsStats.nIRS) / populationSize;
     stream << '\t' << coverage;
 }
 void Population::ctsGVICoverage (ostream& stream){
-    int nActive = 0;
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
-        nActive += iter->perHostTransmission.hasActiveInterv( interventions::Component::GVI );
-    }
-    double coverage = static_cast<double>(nActive) / populationSize;
+    updateCtsStats();
+    double coverage = static_cast<double>(ctsStats.nGVI) / populationSize;
     stream << '\t' << coverage;
 }
+
+void Population::CtsStats::clear(){
+    sumh = 0.0;
+    sumY = 0.0;
+    nPatent = WithinHost::diagnostics::monitoringDiagnostic().isDeterministic() ? 0 : -1;
+    nITN = 0;
+    nIRS = 0;
+    nGVI = 0;
+    valuesY.clear();
+    time = sim::never();
+}
+void Population::CtsStats::add( const Host::Human& human ){
+    const WithinHost::WHInterface& whm = human.getWithinHostModel();
+    sumh += whm.getCumulative_h();
+    sumY += whm.getCumulative_Y();
+    if( wantValuesY ) valuesY.push_back( whm.getCumulative_Y() );
+    if( nPatent >= 0 && whm.diagnosticResult( WithinHost::diagnostics::monitoringDiagnostic() ) )
+        ++nPatent;
+    nITN += human.perHostTransmission.hasActiveInterv( interventions::Component::ITN );
+    nIRS += human.perHostTransmission.hasActiveInterv( interventions::Component::IRS );
+    nGVI += human.perHostTransmission.hasActiveInterv( interventions::Component::GVI );
+}
+void Population::updateCtsStats(){
+    ctsStats.wanted = true;
+    if( ctsStats.time == sim::now() ) return;
+    ctsStats.clear();
+    for( size_t i = 0; i < population.size(); ++i )
+        ctsStats.add( *population[i] );
+    ctsStats.time = sim::now();
+}
 // void Population::ctsNetHoleIndex (ostream& stream){
 //     double meanVar = 0.0;
 //     int nNets = 0;
-//     for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+//     for(Iter iter = begin(); iter != end(); ++iter) {
 //         if( iter->perHostTransmission.getITN().timeOfDeployment() >= sim::zero() ){
 //             ++nNets;
 //             meanVar += iter->perHostTransmission.getITN().getHoleIndex();
@@ -364,14 +551,14 @@ void Population::ctsGVICoverage (ostream& stream){
 
 void Population::newSurvey ()
 {
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+    for(Iter iter = begin(); iter != end(); ++iter) {
         iter->summarize();
     }
     _transmissionModel->summarize();
 }
 
 void Population::flushReports (){
-    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+    for(Iter iter = begin(); iter != end(); ++iter) {
         iter->flushReports();
     }
 }    
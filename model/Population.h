@@ -25,8 +25,9 @@
 #include "PopulationAgeStructure.h"
 #include "Host/Human.h"
 #include "Transmission/TransmissionModel.h"
+#include "util/SlabPool.h"
 
-#include <boost/ptr_container/ptr_list.hpp>
+#include <boost/iterator/indirect_iterator.hpp>
 #include <fstream>
 
 namespace scnXml{
@@ -56,6 +57,7 @@ public:
     template<class S>
     void operator& (S& stream) {
         populationSize & stream;
+        nextHumanId & stream;
 	recentBirths & stream;
         (*_transmissionModel) & stream;
 	
@@ -72,6 +74,10 @@ public:
     /** Initialisation run between initial one-lifespan run of simulation and
      * actual simulation. */
     void preMainSimInit ();
+    
+    /** Reset state which depends on the monitoring configuration (age groups
+     * and cohorts), after loading a warm-up snapshot. */
+    void resetMonitoring ();
 
     //! Updates all individuals in the list for one time-step
     /*!  Also updates the population-level measures such as infectiousness, and
@@ -85,25 +91,39 @@ public:
     /// Flush anything pending report. Should only be called just before destruction.
     void flushReports();
     
-    /// Type of population list. Store pointers to humans only to avoid copy
-    /// operations which (AFAIAA) are otherwise required in C++98.
-    typedef boost::ptr_list<Host::Human> HumanPop;
+    /// Type of population list. Humans themselves live in slabs (see
+    /// humanPool) and never move; the list is a contiguous array of pointers.
+    typedef vector<Host::Human*> HumanPop;
     /// Iterator type of population
-    typedef HumanPop::iterator Iter;
+    typedef boost::indirect_iterator<HumanPop::iterator> Iter;
     /// Const iterator type of population
-    typedef HumanPop::const_iterator ConstIter;
+    typedef boost::indirect_iterator<HumanPop::const_iterator, const Host::Human> ConstIter;
     /// Const reverse iterator type of population
-    typedef HumanPop::const_reverse_iterator ConstReverseIter;
+    typedef boost::indirect_iterator<HumanPop::const_reverse_iterator, const Host::Human> ConstReverseIter;
     
     /** @brief Access the population list, as a whole or with iterators. */
     //@{
     // non-const versions are needed to do things like add infections
-    inline Iter begin() { return population.begin(); }
-    inline Iter end() { return population.end(); }
-    inline ConstIter cbegin() const{ return population.cbegin(); }
-    inline ConstIter cend() const{ return population.cend(); }
-    inline ConstReverseIter crbegin() const{ return population.crbegin(); }
-    inline ConstReverseIter crend() const{ return population.crend(); }
+    inline Iter begin() { return Iter( population.begin() ); }
+    inline Iter end() { return Iter( population.end() ); }
+    inline ConstIter cbegin() const{ return ConstIter( population.begin() ); }
+    inline ConstIter cend() const{ return ConstIter( population.end() ); }
+    inline ConstReverseIter crbegin() const{ return ConstReverseIter( population.rbegin() ); }
+    inline ConstReverseIter crend() const{ return ConstReverseIter( population.rend() ); }
+    /** Find humans whose age at sim::now() is at least minAge and less
+     * than maxAge, setting [first, last) to this range.
+     * 
+     * Humans are kept in order of date of birth (oldest first), so such
+     * humans are contiguous and are found by binary search. */
+    void ageRange( SimTime minAge, SimTime maxAge, Iter& first, Iter& last );
+    /** Set members to the humans in sub-population id (see
+     * Host::Human::isInSubPop) whose age at sim::now() is at least minAge and
+     * less than maxAge, in population order.
+     * 
+     * This uses an index of sub-population members, so the cost depends on
+     * the size of the sub-population, not of the whole population. */
+    void subPopMembers( interventions::ComponentId id, SimTime minAge,
+                        SimTime maxAge, HumanPop& members );
     /** Return the number of humans. */
     inline size_t size() const {
         return populationSize;
@@ -125,6 +145,23 @@ private:
     */
     void newHuman( SimTime dob );
     
+    /// Construct a human in humanPool
+    Host::Human* allocHuman( SimTime dob, uint64_t id );
+    /// Load a human from a checkpoint into humanPool
+    Host::Human* allocHuman( istream& stream );
+    /// Destroy a human created by allocHuman and free its slot
+    void freeHuman( Host::Human* human );
+    
+    /** Run Human::update() for all humans on util::parallel::numThreads()
+     * threads, without removing anyone.
+     * 
+     * Humans are split into contiguous partitions in population order.
+     * Buffered reports are merged in partition order afterwards.
+     * 
+     * @param isDead Output: isDead[i] is set to the result of updating the
+     *  i-th human. */
+    void updatePartitioned( SimTime firstVecInitTS, vector<char>& isDead );
+    
     /// Delegate to print the number of hosts
     void ctsHosts (ostream& stream);
     /// Delegate to print cumulative numbers of hosts under various age limits
@@ -147,6 +184,10 @@ private:
     /// Delegate to print the mean hole index of all bed nets
 //     void ctsNetHoleIndex (ostream& stream);
     
+    /** Make ctsStats valid for sim::now(), scanning the population if they
+     * were not gathered by the last update. */
+    void updateCtsStats();
+    
     void checkpoint (istream& stream);
     void checkpoint (ostream& stream);
 
@@ -154,16 +195,51 @@ private:
     //! Size of the human population
     size_t populationSize;
     
+    /// Identifier to give the next human created (ids are never reused)
+    uint64_t nextHumanId;
+    
     ///@brief Variables for continuous reporting
     //@{
     vector<double> ctsDemogAgeGroups;
     
     /// Births since last continuous output
     int recentBirths;
+    
+    /** Population statistics used by several continuous outputs.
+     * 
+     * Once one of these outputs is used, statistics are gathered at the end
+     * of update1() while passing over the population anyway, in population
+     * order (so sums are identical to those of a separate pass). Before the
+     * first update and after loading a checkpoint they are not valid, and
+     * updateCtsStats() scans the population instead. Not checkpointed. */
+    struct CtsStats {
+        CtsStats() : wanted(false), wantValuesY(false), time(sim::never()) {}
+        
+        /// Reset sums and counts
+        void clear();
+        /// Add a human's state
+        void add( const Host::Human& human );
+        
+        bool wanted;    // gather during update1()
+        bool wantValuesY;       // gather valuesY
+        SimTime time;   // value of sim::now() when valid, or sim::never()
+        
+        double sumh, sumY;
+        // Number of patent humans, or -1 if the monitoring diagnostic uses
+        // random numbers (then the diagnostic must be used during output, as
+        // before, to give the same random number sequence).
+        int nPatent;
+        int nITN, nIRS, nGVI;
+        // cumulative Y of each human (for the median)
+        vector<double> valuesY;
+    } ctsStats;
     //@}
     //! TransmissionModel model
     Transmission::TransmissionModel* _transmissionModel;
     
+    /// Storage for all humans (sub-models use util::slab pools)
+    util::SlabPool humanPool;
+    
     /** The simulated human population
      *
      * The list of all humans, ordered from oldest to youngest. */
@@ -41,8 +41,16 @@
 #include "schema/scenario.h"
 
 #include <fstream>
+#include <cstdio>
 #include <gzstream/gzstream.h>
 
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
 
 namespace OM {
     using Monitoring::Continuous;
@@ -73,12 +81,15 @@ enum Phase {
 
 // ———  Set-up & tear-down  ———
 
-Simulator::Simulator( util::Checksum ck, const scnXml::Scenario& scenario ) :
+Simulator::Simulator( util::Checksum ck, const scnXml::Scenario& scenario,
+                      const string& key ) :
     simPeriodEnd(sim::zero()),
     totalSimDuration(sim::zero()),
     phase(STARTING_PHASE),
     workUnitIdentifier(0),
-    cksum(ck)
+    cksum(ck),
+    warmupKey(key),
+    fromWarmupSnapshot(false)
 {
     // ———  Initialise static data  ———
     
@@ -89,7 +100,9 @@ Simulator::Simulator( util::Checksum ck, const scnXml::Scenario& scenario ) :
     Parameters parameters( model.getParameters() );     // depends on nothing
     WithinHost::Genotypes::init( scenario );
     
-    util::random::seed( model.getParameters().getIseed() );
+    util::random::seed( model.getParameters().getIseed(),
+            util::CommandLine::option( util::CommandLine::RNG_PHILOX ) ?
+            util::random::PHILOX : util::random::MT19937 );
     util::ModelOptions::init( model.getModelOptions() );
     
     // 2) elements depending on only elements initialised in (1):
@@ -159,10 +172,13 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
     
     if (isCheckpoint()) {
         Continuous.init( monitoring, true );
+        mon::initOutput( true );
         readCheckpoint();
     } else {
         Continuous.init( monitoring, false );
-        population->createInitialHumans();
+        mon::initOutput( false );
+        if( warmupKey.empty() || !readWarmupSnapshot() )
+            population->createInitialHumans();
     }
     // Set to either a checkpointing time step or min int value. We only need to
     // set once, since we exit after a checkpoint triggered this way.
@@ -179,6 +195,7 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
                 util::BoincWrapper::checkpointCompleted();
             }
             if( testCheckpointDieTime == sim::now() ){
+                checkpointWriter.finish();
                 throw util::cmd_exception ("Checkpoint test: checkpoint written", util::Error::None);
             }
             
@@ -203,14 +220,23 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
             //  sim::ts1(), to replace those lost.
             
             // do reporting (continuous and surveys)
-            Continuous.update( *population );
+            {
+                OM_PROFILE_SCOPE( CTS_UPDATE );
+                Continuous.update( *population );
+            }
             if( sim::intervNow() == mon::nextSurveyTime() ){
+                OM_PROFILE_SCOPE( NEW_SURVEY );
+                OM_PROFILE_ITEMS( NEW_SURVEY, population->size() );
                 population->newSurvey();
                 mon::concludeSurvey();
             }
             
             // deploy interventions
-            InterventionManager::deploy( *population );
+            {
+                OM_PROFILE_SCOPE( INTERVENTION_DEPLOY );
+                OM_PROFILE_ITEMS( INTERVENTION_DEPLOY, population->size() );
+                InterventionManager::deploy( *population );
+            }
             
             // update humans and mosquitoes
             
@@ -220,7 +246,11 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
 #ifndef NDEBUG
             sim::in_update = true;
 #endif
-            population->update1( humanWarmupLength );
+            {
+                OM_PROFILE_SCOPE( POPULATION_UPDATE );
+                OM_PROFILE_ITEMS( POPULATION_UPDATE, population->size() );
+                population->update1( humanWarmupLength );
+            }
 #ifndef NDEBUG
             sim::in_update = false;
 #endif
@@ -246,6 +276,12 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
             // adjust estimation of final time step: end of current period + length of main phase
             totalSimDuration = simPeriodEnd + mon::finalSurveyTime() + sim::oneTS();
         } else if (phase == MAIN_PHASE) {
+            // State here depends only on the warm-up:
+            if( !warmupKey.empty() && !fromWarmupSnapshot )
+                writeWarmupSnapshot();
+            if( util::CommandLine::option( util::CommandLine::WARMUP_ONLY ) )
+                throw util::cmd_exception( "Warm-up snapshot written", util::Error::None );
+            
             // Start MAIN_PHASE:
             simPeriodEnd = totalSimDuration;
             sim::interv_time = sim::zero();
@@ -280,7 +316,9 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
     // Note: we don't end this critical section; we simply exit.
     util::BoincWrapper::beginCriticalSection();
     
+    checkpointWriter.finish();
     PopulationStats::print();
+    util::profile::print( cerr );
     
     population->flushReports();        // ensure all Human instances report past events
     mon::writeSurveyData();
@@ -309,6 +347,10 @@ void Simulator::writeCheckpoint(){
     // We alternate between two checkpoints, in case program is closed while writing.
     const int NUM_CHECKPOINTS = 2;
     
+    const bool async = util::CommandLine::option (util::CommandLine::ASYNC_CHECKPOINTS);
+    // The previous write must complete before we read the pointer file
+    checkpointWriter.finish();
+    
     int oldCheckpointNum = 0, checkpointNum = 0;
     if (isCheckpoint()) {
         oldCheckpointNum = readCheckpointNum();
@@ -316,6 +358,36 @@ void Simulator::writeCheckpoint(){
         checkpointNum = mod_nn(oldCheckpointNum + 1, NUM_CHECKPOINTS);
     }
     
+    if( async ){
+        // Serialise to memory, then compress and write in the background.
+        // The pointer file is only replaced once the new file is on disk.
+        ostringstream name, oldName, num;
+        name << CHECKPOINT << checkpointNum;
+        oldName << CHECKPOINT << oldCheckpointNum;
+        const bool compress = util::CommandLine::option (util::CommandLine::COMPRESS_CHECKPOINTS);
+        if( compress ){
+            name << ".gz";
+            oldName << ".gz";
+        }
+        num << checkpointNum;
+        string truncate;
+        if( oldCheckpointNum != checkpointNum
+            && !util::CommandLine::option (util::CommandLine::TEST_DUPLICATE_CHECKPOINTS) )
+            truncate = oldName.str();
+        
+        // the seed file (if any) is written by the same job, before the pointer
+        ostringstream buf (ios::out | ios::binary);
+        string seedData;
+        checkpoint (buf, checkpointNum, &seedData);
+        string data = buf.str();
+        string seedFile;
+        if( !seedData.empty() )
+            seedFile = string("seed") + num.str();
+        checkpointWriter.write( data, name.str(), compress, seedFile, seedData,
+                CHECKPOINT, num.str(), truncate );
+        return;
+    }
+    
     {   // Open the next checkpoint file for writing:
         ostringstream name;
         name << CHECKPOINT << checkpointNum;
@@ -390,6 +462,7 @@ void Simulator::readCheckpoint() {
 // ———  checkpointing: Simulation data  ———
 
 void Simulator::checkpoint (istream& stream, int checkpointNum) {
+    OM_PROFILE_SCOPE( CHECKPOINT );
     try {
         util::checkpoint::header (stream);
         util::CommandLine::staticCheckpoint (stream);
@@ -440,7 +513,8 @@ void Simulator::checkpoint (istream& stream, int checkpointNum) {
         throw util::checkpoint_error ("stream read error");
 }
 
-void Simulator::checkpoint (ostream& stream, int checkpointNum) {
+void Simulator::checkpoint (ostream& stream, int checkpointNum, string* seedData) {
+    OM_PROFILE_SCOPE( CHECKPOINT );
     util::checkpoint::header (stream);
     if (!stream.good())
         throw util::checkpoint_error ("Unable to write to file");
@@ -464,7 +538,7 @@ void Simulator::checkpoint (ostream& stream, int checkpointNum) {
     
     sim::time0 & stream;
     sim::time1 & stream;
-    util::random::checkpoint (stream, checkpointNum);
+    util::random::checkpoint (stream, checkpointNum, seedData);
     workUnitIdentifier & stream;
     cksum & stream;
     
@@ -473,4 +547,100 @@ void Simulator::checkpoint (ostream& stream, int checkpointNum) {
         throw util::checkpoint_error ("stream write error");
 }
 
+
+
+// ———  warm-up snapshots  ———
+
+string Simulator::warmupSnapshotFile( const string& key ){
+    return util::CommandLine::getWarmupSnapshotDir() + "/warmup-" + key + ".gz";
+}
+
+bool Simulator::readWarmupSnapshot(){
+    string name = warmupSnapshotFile( warmupKey );
+    igzstream in(name.c_str(), ios::in | ios::binary);
+    //Note: gzstreams are considered "good" when file not open!
+    if ( !( in.good() && in.rdbuf()->is_open() ) )
+        return false;   // no snapshot yet: run the warm-up
+    try {
+        warmupSnapshot( in );
+    } catch (const util::checkpoint_error& e) {
+        throw util::checkpoint_error( string("warm-up snapshot ") + name + ": " + e.what() );
+    }
+    in.close();
+    
+    // Continue as at the end of TRANSMISSION_INIT; the main phase starts
+    // immediately.
+    fromWarmupSnapshot = true;
+    phase = TRANSMISSION_INIT;
+    simPeriodEnd = sim::now();
+    totalSimDuration = simPeriodEnd + mon::finalSurveyTime() + sim::oneTS();
+    cerr << sim::now().inSteps() << "t warm-up loaded" << endl;
+    return true;
+}
+
+void Simulator::writeWarmupSnapshot(){
+    string name = warmupSnapshotFile( warmupKey );
+    if( util::BoincWrapper::fileExists( name.c_str() ) )
+        return;         // e.g. written by another run in the meantime
+    
+    // Write to a temporary file then rename, so that other runs never see a
+    // partial snapshot.
+    ostringstream tmp;
+    tmp << name << ".tmp" << getpid();
+    try {
+        ogzstream out(tmp.str().c_str(), ios::out | ios::binary);
+        if ( !out.rdbuf()->is_open() )
+            throw util::checkpoint_error( "unable to open " + tmp.str() );
+        warmupSnapshot( out );
+        out.close();
+        if( rename( tmp.str().c_str(), name.c_str() ) != 0 )
+            throw util::checkpoint_error( "unable to rename " + tmp.str() );
+    } catch (const util::checkpoint_error& e) {
+        // The simulation can continue without it
+        remove( tmp.str().c_str() );
+        cerr << "Warning: warm-up snapshot not saved: " << e.what() << endl;
+    }
+}
+
+void Simulator::warmupSnapshot (istream& stream) {
+    util::checkpoint::header (stream);
+    string key;
+    key & stream;
+    if (key != warmupKey)
+        throw util::checkpoint_error ("mismatched key");
+    Population::staticCheckpoint (stream);
+    PopulationStats::staticCheckpoint( stream );
+    (*population) & stream;
+    
+    // read last, as in checkpoint()
+    sim::time0 & stream;
+    sim::time1 & stream;
+    sim::interv_time & stream;
+    util::random::checkpoint (stream, -1);
+    
+    stream.ignore (numeric_limits<streamsize>::max()-1);        // skip to end of file
+    if (stream.gcount () != 0 || stream.bad())
+        throw util::checkpoint_error ("unexpected data at end");
+    
+    // Monitoring may differ from that of the run which wrote the snapshot
+    population->resetMonitoring();
+}
+
+void Simulator::warmupSnapshot (ostream& stream) {
+    util::checkpoint::header (stream);
+    if (!stream.good())
+        throw util::checkpoint_error ("unable to write");
+    warmupKey & stream;
+    Population::staticCheckpoint (stream);
+    PopulationStats::staticCheckpoint( stream );
+    (*population) & stream;
+    
+    sim::time0 & stream;
+    sim::time1 & stream;
+    sim::interv_time & stream;
+    util::random::checkpoint (stream, -1);
+    if (stream.fail())
+        throw util::checkpoint_error ("stream write error");
+}
+
 }
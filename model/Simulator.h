@@ -24,6 +24,7 @@
 #include "Global.h"
 #include "Population.h"
 #include "util/BoincWrapper.h"
+#include "util/CheckpointWriter.h"
 #include <memory>
 using namespace std;
 
@@ -39,8 +40,12 @@ namespace interventions{
 //! Main simulation class
 class Simulator{
 public: 
-    //!  Inititalise all step specific constants and variables.
-    Simulator( util::Checksum ck, const scnXml::Scenario& scenario );
+    /** Inititalise all step specific constants and variables.
+     * 
+     * @param warmupKey Identifies the warm-up (see
+     *  DocumentLoader::getWarmupKey()); empty when not using snapshots. */
+    Simulator( util::Checksum ck, const scnXml::Scenario& scenario,
+               const string& warmupKey );
     
     //! Entry point to simulation.
     void start(const scnXml::Monitoring& monitoring);
@@ -48,17 +53,37 @@ public:
     /// Return true when this simulation started by loading a checkpoint
     inline static bool isCheckpoint(){ return startedFromCheckpoint; }
     
+    /// Name of the warm-up snapshot file for a key (see --warmup-snapshot)
+    static string warmupSnapshotFile( const string& key );
+    
 private:
     /** @brief checkpointing functions
     *
     * readCheckpoint/writeCheckpoint prepare to read/write the file,
-    * and read/write read and write the actual data. */
+    * and read/write read and write the actual data. If seedData is not null,
+    * the random number generator's seed file content is put there instead of
+    * being written (see util::random::checkpoint). */
     //@{
     void writeCheckpoint();
     void readCheckpoint();
     
     void checkpoint (istream& stream, int checkpointNum);
-    void checkpoint (ostream& stream, int checkpointNum);
+    void checkpoint (ostream& stream, int checkpointNum, string* seedData = 0);
+    //@}
+    
+    /** @brief Warm-up snapshots (see --warmup-snapshot)
+     * 
+     * A snapshot holds the state at the end of the warm-up, excluding
+     * monitoring and intervention state, which is set up from the scenario
+     * being run instead. */
+    //@{
+    /// Load the snapshot if it exists; return true if loaded
+    bool readWarmupSnapshot();
+    /// Save a snapshot; failures are reported but not fatal
+    void writeWarmupSnapshot();
+    
+    void warmupSnapshot (istream& stream);
+    void warmupSnapshot (ostream& stream);
     //@}
     
     // Data
@@ -68,6 +93,9 @@ private:
     
     auto_ptr<Population> population;
     
+    /// Used when checkpoints are written in the background
+    util::CheckpointWriter checkpointWriter;
+    
     /** This was used to prevent checksum cheats; now it is obseleted by cksum.
      * NOTE: could be removed, but there's little point and could be
      * complications for the BOINC server. */
@@ -76,6 +104,11 @@ private:
     // Stored so that it can be verified across checkpoints
     util::Checksum cksum;
     
+    /// Key of the warm-up snapshot (empty if not used)
+    string warmupKey;
+    /// True when the warm-up was loaded from a snapshot
+    bool fromWarmupSnapshot;
+    
     static bool startedFromCheckpoint;
     
     friend class AnophelesModelSuite;
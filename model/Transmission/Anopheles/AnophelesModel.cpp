@@ -283,7 +283,7 @@ void AnophelesModel::deployVectorTrap(size_t instance, double number, SimTime li
 }
 
 // Every sim::oneTS() days:
-void AnophelesModel::advancePeriod (const OM::Population& population,
+void AnophelesModel::advancePeriod (const HostTraits& traits,
                                      vector2D<double>& popProbTransmission,
                                      size_t sIndex,
                                      bool isDynamic) {
@@ -332,19 +332,20 @@ void AnophelesModel::advancePeriod (const OM::Population& population,
     // P_dif; here we assume that P_E is constant.
     double tsP_df = 0.0;
     vector<double> tsP_dif( WithinHost::Genotypes::N(), 0.0 );
-    size_t i = 0;
-    for(Population::ConstIter h = population.cbegin(); h != population.cend(); ++h, ++i) {
-        const OM::Transmission::PerHost& host = h->perHostTransmission;
-        //NOTE: calculate availability relative to age at end of time step;
-        // not my preference but consistent with TransmissionModel::getEIR().
-        //TODO: even stranger since popProbTransmission comes from the previous time step
-        const double avail = host.entoAvailabilityFull (humanBase, sIndex, h->age(sim::ts1()).inYears());
-        leaveSeekingStateRate += avail;
-        const double P_df = avail
-                * host.probMosqBiting(humanBase, sIndex)
-                * host.probMosqResting(humanBase, sIndex);
+    //NOTE: availability is relative to age at end of time step (see
+    // VectorModel::vectorUpdate); not my preference but consistent with
+    // TransmissionModel::getEIR().
+    //TODO: even stranger since popProbTransmission comes from the previous time step
+    const size_t nHumans = traits.numHumans, offset = sIndex * nHumans;
+    const double *avail = nHumans ? &traits.avail[offset] : 0;
+    const double *P_B = nHumans ? &traits.probBiting[offset] : 0;
+    const double *P_CD = nHumans ? &traits.probResting[offset] : 0;
+    const size_t nGenotypes = WithinHost::Genotypes::N();
+    for( size_t i = 0; i < nHumans; ++i ){
+        leaveSeekingStateRate += avail[i];
+        const double P_df = avail[i] * P_B[i] * P_CD[i];
         tsP_df += P_df;
-        for( size_t genotype = 0; genotype < WithinHost::Genotypes::N(); ++genotype ){
+        for( size_t genotype = 0; genotype < nGenotypes; ++genotype ){
             tsP_dif[genotype] += P_df * popProbTransmission.at(i, genotype);
         }
     }
@@ -40,6 +40,23 @@ namespace Anopheles {
     using std::numeric_limits;
     using util::vector2D;
 
+/** Per-human, per-species factors of the human population used by the vector
+ * model, evaluated once per time step (see VectorModel::fillHostTraits).
+ * 
+ * Arrays are species-major: the value for species s and the i-th human (in
+ * population order) is at index s * numHumans + i. */
+struct HostTraits {
+    HostTraits() : numHumans(0) {}
+    
+    size_t numHumans;
+    /// Availability α_i (PerHost::entoAvailabilityFull)
+    vector<double> avail;
+    /// P_B_i (PerHost::probMosqBiting)
+    vector<double> probBiting;
+    /// P_C_i * P_D_i (PerHost::probMosqResting)
+    vector<double> probResting;
+};
+
 /** Per-species part for vector transmission model.
  *
  * Data in this class is specific to a species of anopheles mosquito, where
@@ -126,8 +143,8 @@ public:
     //@{
     /** Called per time-step. Does most of calculation of EIR.
      *
-     * @param population The human population; so we can sum up availability and
-     *  infectiousness.
+     * @param traits Availability and biting/resting probabilities of each
+     *  human for each species, in the same order as popProbTransmission.
      * @param popProbTransmission A two-dimensional vector of the probability
      *  of transmission to mosquito for each human host (first index, in same
      *  order as population) and for each parasite genotype (second index).
@@ -136,7 +153,7 @@ public:
      * @param sIndex Index of the type of mosquito in per-type/species lists.
      * @param isDynamic True to use full model; false to drive model from current contents of S_v.
      */
-    void advancePeriod( const OM::Population& population,
+    void advancePeriod( const HostTraits& traits,
                         vector2D<double>& popProbTransmission,
                         size_t sIndex, bool isDynamic );
 
@@ -42,6 +42,7 @@ MosqTransmission::MosqTransmission() :
         EIPDuration(sim::zero()),
         N_v_length(sim::zero()),
         minInfectedThreshold( std::numeric_limits< double >::quiet_NaN() ),     // requires config
+        sameP_days(0),
         timeStep_N_v0(0.0)
 {
     // Warning: don't allocate memory here. The whole instance will be
@@ -103,6 +104,8 @@ void MosqTransmission::initialise ( const scnXml::AnophelesParams::LifeCycleOpti
     ftauArray[mosqRestDuration] = 1.0;
     uninfected_v.resize(N_v_length);
     uninfected_v[sim::zero()] = numeric_limits<double>::quiet_NaN();    // index not used
+    histP_A.resize(N_v_length.inDays());
+    histP_df.resize(N_v_length.inDays());
 }
 
 void MosqTransmission::initIterateScale ( double factor ){
@@ -122,6 +125,8 @@ void MosqTransmission::initState ( double tsP_A, double tsP_df,
     P_A  .resize (N_v_length);
     P_df .resize (N_v_length);
     P_dif.assign (N_v_length, Genotypes::N(), 0.0);// humans start off with no infectiousness.. so just wait
+    sumS_v.resize (Genotypes::N());
+    sameP_days = 0;
     
     // Initialize per-day variables; S_v, N_v and O_v are only estimated
     assert( N_v_length <= forcedS_v.size() );
@@ -137,100 +142,139 @@ void MosqTransmission::initState ( double tsP_A, double tsP_df,
 }
 
 
+// Index of the day n days before that with index t, in a ring buffer of length len
+inline int daysBack( int t, int n, int len ){
+    int r = t - n;
+    return r < 0 ? r + len : r;
+}
+
 void MosqTransmission::update( SimTime d0, double tsP_A, double tsP_df,
         const vector<double> tsP_dif, bool isDynamic,
         vector<double>& partialEIR, double EIR_factor )
 {
-    SimTime d1 = d0 + sim::oneDay();    // end of step
+    // Everything below works on plain day indices and raw arrays.
+    const int len = N_v_length.inDays();
+    const int tau = mosqRestDuration.inDays();
+    const int theta_s = EIPDuration.inDays();
+    const size_t nGenotypes = Genotypes::N();
     
-    // We add N_v_length so that we can use mod_nn() instead of mod().
-    SimTime d1Mod = d1 + N_v_length;
-    assert (d1Mod >= N_v_length);
     // Indecies for end time, start time, and mosqRestDuration days before end time:
-    SimTime t1    = mod_nn(d1, N_v_length);
-    SimTime t0   = mod_nn(d0, N_v_length);
-    SimTime ttau = mod_nn(d1Mod - mosqRestDuration, N_v_length);
+    const int t1 = mod_nn(d0.inDays() + 1, len);
+    const int t0 = daysBack(t1, 1, len);
+    const int ttau = daysBack(t1, tau, len);
+    
+    double *pA = &P_A.internal_vec()[0];
+    double *pDf = &P_df.internal_vec()[0];
+    double *nV = &N_v.internal_vec()[0];
+    double *f = &fArray.internal_vec()[0];
+    double *ftau = &ftauArray.internal_vec()[0];
+    double *uninf = &uninfected_v.internal_vec()[0];
+    
+    // f and f_τ only use P_A and P_df from the previous θ_s - 1 days. If
+    // these were the same over the previous θ_s days, yesterday's values are
+    // still valid.
+    const bool reuseF = sameP_days >= theta_s;
+    if( tsP_A == pA[t0] && tsP_df == pDf[t0] ) sameP_days += 1;
+    else sameP_days = 1;
     
     // These only need to be calculated once per time step, but should be
     // present in each of the previous N_v_length - 1 positions of arrays.
-    P_A[t1] = tsP_A;
-    P_df[t1] = tsP_df;
-    for( size_t i = 0; i < Genotypes::N(); ++i )
-        P_dif.at(t1,i) = tsP_dif[i];
+    pA[t1] = tsP_A;
+    pDf[t1] = tsP_df;
+    for( size_t i = 0; i < nGenotypes; ++i )
+        P_dif.at(sim::fromDays(t1),i) = tsP_dif[i];
     
     
     //BEGIN cache calculation: fArray, ftauArray, uninfected_v
-    // Set up array with n in 1..θ_s−τ for f(d1Mod-n) (NDEMD eq. 1.6)
-    for( SimTime n = sim::oneDay(); n <= mosqRestDuration; n += sim::oneDay() ){
-        const SimTime tn = mod_nn(d1Mod-n, N_v_length);
-        fArray[n] = fArray[n-sim::oneDay()] * P_A[tn];
+    if( !reuseF ){
+        // Unroll the ring buffers: hA[n] = P_A for day d1-n, etc.
+        double *hA = &histP_A[0], *hDf = &histP_df[0];
+        for( int n = 0; n <= t1; ++n ){
+            hA[n] = pA[t1 - n];
+            hDf[n] = pDf[t1 - n];
+        }
+        for( int n = t1 + 1; n < len; ++n ){
+            hA[n] = pA[t1 - n + len];
+            hDf[n] = pDf[t1 - n + len];
+        }
+        
+        // Set up array with n in 1..θ_s−τ for f(d1Mod-n) (NDEMD eq. 1.6)
+        for( int n = 1; n <= tau; ++n )
+            f[n] = f[n-1] * hA[n];
+        f[tau] += hDf[tau];
+        
+        const int fAEnd = theta_s - tau;
+        for( int n = tau + 1; n <= fAEnd; ++n )
+            f[n] = hDf[n] * f[n - tau] + hA[n] * f[n-1];
+        
+        // Set up array with n in 1..θ_s−1 for f_τ(d1Mod-n) (NDEMD eq. 1.7)
+        const int fProdEnd = tau * 2;
+        for( int n = tau + 1; n <= fProdEnd; ++n )
+            ftau[n] = ftau[n-1] * hA[n];
+        ftau[fProdEnd] += hDf[fProdEnd];
+        
+        for( int n = fProdEnd + 1; n < theta_s; ++n )
+            ftau[n] = hDf[n] * ftau[n - tau] + hA[n] * ftau[n-1];
     }
-    fArray[mosqRestDuration] += P_df[ttau];
     
-    const SimTime fAEnd = EIPDuration-mosqRestDuration;
-    for( SimTime n = mosqRestDuration+sim::oneDay(); n <= fAEnd; n += sim::oneDay() ){
-        const SimTime tn = mod_nn(d1Mod-n, N_v_length);
-        fArray[n] =
-            P_df[tn] * fArray[n - mosqRestDuration]
-            + P_A[tn] * fArray[n-sim::oneDay()];
+    // Only the entries used below: τ and θ_s..N_v_length-1
+    for( int d = tau; d < len; d = (d == tau ? theta_s : d + 1) ){
+        const int t = daysBack(t1, d, len);
+        const double *oV = &O_v.at(sim::fromDays(t), 0);
+        double sum = nV[t];
+        for( size_t i = 0; i < nGenotypes; ++i ) sum -= oV[i];
+        uninf[d] = sum;
     }
+    //END cache calculation: fArray, ftauArray, uninfected_v
     
-    // Set up array with n in 1..θ_s−1 for f_τ(d1Mod-n) (NDEMD eq. 1.7)
-    const SimTime fProdEnd = mosqRestDuration * 2;
-    for( SimTime n = mosqRestDuration+sim::oneDay(); n <= fProdEnd; n += sim::oneDay() ){
-        SimTime tn = mod_nn(d1Mod-n, N_v_length);
-        ftauArray[n] = ftauArray[n-sim::oneDay()] * P_A[tn];
-    }
-    ftauArray[fProdEnd] += P_df[mod_nn(d1Mod-fProdEnd, N_v_length)];
-
-    for( SimTime n = fProdEnd+sim::oneDay(); n < EIPDuration; n += sim::oneDay() ){
-        SimTime tn = mod_nn(d1Mod-n, N_v_length);
-        ftauArray[n] =
-            P_df[tn] * ftauArray[n - mosqRestDuration]
-            + P_A[tn] * ftauArray[n-sim::oneDay()];
+    // Rows (over genotypes) of the per-day arrays:
+    const double *P_dif_tau = &P_dif.at(sim::fromDays(ttau), 0);
+    const double *O_v0 = &O_v.at(sim::fromDays(t0), 0);
+    const double *O_vtau = &O_v.at(sim::fromDays(ttau), 0);
+    double *O_v1 = &O_v.at(sim::fromDays(t1), 0);
+    const double *S_v0 = &S_v.at(sim::fromDays(t0), 0);
+    const double *S_vtau = &S_v.at(sim::fromDays(ttau), 0);
+    double *S_v1 = &S_v.at(sim::fromDays(t1), 0);
+    const double P_A0 = pA[t0], P_df_tau = pDf[ttau];
+    
+    // Num infected seeking mosquitoes is the new ones (those who were
+    // uninfected tau days ago, started a feeding cycle then, survived and
+    // got infected) + those who didn't find a host yesterday + those who
+    // found a host tau days ago and survived a feeding cycle.
+    const double uninf_tau = uninf[tau];
+    for( size_t g = 0; g < nGenotypes; ++g ){
+        O_v1[g] = P_dif_tau[g] * uninf_tau
+                + P_A0  * O_v0[g]
+                + P_df_tau * O_vtau[g];
     }
     
-    for( SimTime d = sim::oneDay(); d < N_v_length; d += sim::oneDay() ){
-        SimTime t = mod_nn(d1Mod - d, N_v_length);
-        double sum = N_v[t];
-        for( size_t i = 0; i < Genotypes::N(); ++i ) sum -= O_v.at(t,i);
-        uninfected_v[d] = sum;
+    //BEGIN S_v
+    // sum over l in 1..τ-1 of P_dif[d1-θ_s-l] * P_df[d1-τ] *
+    // uninfected_v[θ_s+l] * f_τ[θ_s+l-τ], accumulated per genotype:
+    double *sum = &sumS_v[0];
+    for( size_t g = 0; g < nGenotypes; ++g ) sum[g] = 0.0;
+    for( int l = 1; l < tau; ++l ){
+        const double *P_dif_l = &P_dif.at(sim::fromDays(daysBack(t1, theta_s + l, len)), 0);
+        const double factor = P_df_tau * uninf[theta_s+l] * ftau[theta_s+l-tau];
+        for( size_t g = 0; g < nGenotypes; ++g )
+            sum[g] += P_dif_l[g] * factor;
     }
-    //END cache calculation: fArray, ftauArray, uninfected_v
     
+    const double *P_dif_s = &P_dif.at(sim::fromDays(daysBack(t1, theta_s, len)), 0);  // index d1 - theta_s
+    const double newInfectious = f[theta_s-tau] * uninf[theta_s];
     double total_S_v = 0.0;
-    for( size_t genotype = 0; genotype < Genotypes::N(); ++genotype ){
-        // Num infected seeking mosquitoes is the new ones (those who were
-        // uninfected tau days ago, started a feeding cycle then, survived and
-        // got infected) + those who didn't find a host yesterday + those who
-        // found a host tau days ago and survived a feeding cycle.
-        O_v.at(t1,genotype) = P_dif.at(ttau,genotype) * uninfected_v[mosqRestDuration]
-                    + P_A[t0]  * O_v.at(t0,genotype)
-                    + P_df[ttau] * O_v.at(ttau,genotype);
+    for( size_t g = 0; g < nGenotypes; ++g ){
+        S_v1[g] = P_dif_s[g] * newInfectious
+            + sum[g]
+            + P_A0 * S_v0[g]
+            + P_df_tau * S_vtau[g];
         
-        //BEGIN S_v
-        double sum = 0.0;
-        const SimTime ts = d1Mod - EIPDuration;
-        for( SimTime l = sim::oneDay(); l < mosqRestDuration; l += sim::oneDay() ){
-            const SimTime tsl = mod_nn(ts - l, N_v_length); // index d1Mod - theta_s - l
-            sum += P_dif.at(tsl,genotype) * P_df[ttau] * (uninfected_v[EIPDuration+l]) *
-                    ftauArray[EIPDuration+l-mosqRestDuration];
-        }
-        
-        const SimTime tsm = mod_nn(ts, N_v_length);       // index d1Mod - theta_s
-        S_v.at(t1,genotype) = P_dif.at(tsm,genotype) *
-                fArray[EIPDuration-mosqRestDuration] * (uninfected_v[EIPDuration])
-            + sum
-            + P_A[t0]*S_v.at(t0,genotype)
-            + P_df[ttau]*S_v.at(ttau,genotype);
-
-
         if( isDynamic ){
             // We cut-off transmission when no more than X mosquitos are infected to
             // allow true elimination in simulations. Unfortunately, it may cause problems with
             // trying to simulate extremely low transmission, such as an R_0 case.
-            if ( S_v.at(t1,genotype) <= minInfectedThreshold ) { // infectious mosquito cut-off
-                S_v.at(t1,genotype) = 0.0;
+            if ( S_v1[g] <= minInfectedThreshold ) { // infectious mosquito cut-off
+                S_v1[g] = 0.0;
                 /* Note: could report; these reports often occur too frequently, however
                 if( S_v[t1] != 0.0 ){        // potentially reduce reporting
             cerr << sim::ts0() <<":\t S_v cut-off"<<endl;
@@ -238,32 +282,22 @@ void MosqTransmission::update( SimTime d0, double tsP_A, double tsP_df,
             }
         }
         
-        partialEIR[genotype] += S_v.at(t1, genotype) * EIR_factor;
-        total_S_v += S_v.at(t1, genotype);
-        //END S_v
+        partialEIR[g] += S_v1[g] * EIR_factor;
+        total_S_v += S_v1[g];
     }
+    //END S_v
     
-    const double nOvipositing = P_df[ttau] * N_v[ttau];       // number ovipositing on this step
+    const double nOvipositing = P_df_tau * nV[ttau];       // number ovipositing on this step
     const double newAdults = emergence->update( d0, nOvipositing, total_S_v );
     util::streamValidate( newAdults );
     
     // num seeking mosquitos is: new adults + those which didn't find a host
     // yesterday + those who found a host tau days ago and survived cycle:
-    N_v[t1] = newAdults
-                + P_A[t0]  * N_v[t0]
+    nV[t1] = newAdults
+                + P_A0  * nV[t0]
                 + nOvipositing;
     
     timeStep_N_v0 += newAdults;
-    
-//     if( printDebug ){
-//         cerr<<"step ending "<<d1<<" (days):\temergence "<<newAdults<<",\tN_v "<<N_v[t1]<<",\tS_v "<<total_S_v<<endl;
-        //cerr << "len: "<<N_v_length<<"\td1Mod: "<<d1Mod<<"\tt(0,1): "<<t0<<" "<<t1<<" "<<ttau<<endl;
-/*        cerr<<"P_A\t"<<P_A[t0]<<"\t"<<P_A[t1]<<"\t"<<P_A[ttau]<<endl;
-        cerr<<"P_df\t"<<P_df[t0]<<"\t"<<P_df[t1]<<"\t"<<P_df[ttau]<<endl;
-        cerr<<"P_dif\t"<<P_dif[t0]<<"\t"<<P_dif[t1]<<"\t"<<P_dif[ttau]<<endl;*/
-//         cerr<<ftauArray<<endl;
-//         cerr<<fArray<<endl;
-//     }
 }
 
 
@@ -29,6 +29,7 @@
 #include <boost/shared_ptr.hpp>
 
 class MosqLifeCycleSuite;
+class MosqTransmissionSuite;
 
 namespace OM {
 namespace Transmission {
@@ -235,11 +236,13 @@ private:
     /** Used for calculations within advancePeriod. Only saved for optimisation.
      *
      * Used to calculate recursive functions f and f_τ in NDEMD eq 1.6, 1.7.
-     * Values are recalculated each step; only fArray[0] and
+     * Values are recalculated each step (fArray and ftauArray only when
+     * needed; see sameP_days); only fArray[0] and
      * ftauArray[0..mosqRestDuration] are stored across steps for optimisation
      * (reallocating each time they are needed would be slow).
      * 
-     * uninfected_v[0] is not used.
+     * Only uninfected_v[τ] and uninfected_v[θ_s..N_v_length-1] are used (and
+     * updated).
      *
      * Length (fArray): EIPDuration - mosqRestDuration + 1 (θ_s - τ + 1)
      * Length (ftauArray): EIPDuration (θ_s)
@@ -252,10 +255,27 @@ private:
     vecDay<double> uninfected_v;
     //@}
     
+    /** More working memory for update(), not checkpointed.
+     * 
+     * histP_A[n] and histP_df[n] hold P_A and P_df for n days before the end
+     * of the current day (unrolled from the ring buffers), and sumS_v is a
+     * per-genotype accumulator. */
+    //@{
+    std::vector<double> histP_A, histP_df, sumS_v;
+    //@}
+    
+    /** Number of consecutive days, up to and including the last update, for
+     * which P_A and P_df were unchanged. fArray and ftauArray only depend on
+     * the last EIPDuration days of these, so need not be recalculated when
+     * this is long enough. Reset by initState(); not checkpointed (after a
+     * restore arrays are simply recalculated). */
+    int sameP_days;
+    
     /** Variables tracking data to be reported. */
     double timeStep_N_v0;
     
     friend class ::MosqLifeCycleSuite;
+    friend class ::MosqTransmissionSuite;
 };
 
 }
@@ -33,6 +33,7 @@
 #include "util/CommandLine.h"
 #include "util/vectors.h"
 #include "util/ModelOptions.h"
+#include "util/parallel.h"
 
 #include <cmath>
 #include <cfloat>
@@ -124,10 +125,18 @@ TransmissionModel::TransmissionModel(const scnXml::Entomology& entoData,
     surveySimulatedEIR(0.0),
     adultAge(PerHost::adultAge()),
     numTransmittingHumans(0),
-    tsNumAdults(0)
+    tsNumAdults(0),
+    nSurveyGenotypes(nGenotypes)
 {
     initialisationEIR.assign (sim::stepsPerYear(), 0.0);
     surveyInoculations.assign(survInocsSize(nGenotypes), 0.0);
+    if( util::parallel::numThreads() > 1 ){
+        PartitionSums zero;
+        zero.adultEntoInocs = 0.0;
+        zero.numAdults = 0;
+        zero.inoculations.assign(surveyInoculations.size(), 0.0);
+        partitionSums.assign(util::parallel::numThreads(), zero);
+    }
     
   using Monitoring::Continuous;
   Continuous.registerCallback( "input EIR", "\tinput EIR", MakeDelegate( this, &TransmissionModel::ctsCbInputEIR ) );
@@ -202,6 +211,20 @@ double TransmissionModel::getEIR( Host::Human& human, SimTime age,
     calculateEIR( human, ageYears, EIR );
     util::streamValidate( EIR );
     
+    if( util::parallel::active() ){
+        PartitionSums& sums = partitionSums[util::parallel::partition()];
+        for( size_t g = 0, nG = EIR.size(); g < nG; ++g ){
+            size_t index = survInocsIndex(human.monAgeGroup().i(), human.cohortSet(), g);
+            sums.inoculations[index] += EIR[g];
+        }
+        double allEIR = vectors::sum( EIR );
+        if( age >= adultAge ){
+            sums.adultEntoInocs += allEIR;
+            sums.numAdults += 1;
+        }
+        return allEIR;
+    }
+    
     for( size_t g = 0, nG = EIR.size(); g < nG; ++g ){
         size_t index = survInocsIndex(human.monAgeGroup().i(), human.cohortSet(), g);
         surveyInoculations[index] += EIR[g];
@@ -215,6 +238,21 @@ double TransmissionModel::getEIR( Host::Human& human, SimTime age,
     return allEIR;
 }
 
+void TransmissionModel::mergePartitions () {
+    assert( !util::parallel::active() );
+    for( size_t p = 0; p < partitionSums.size(); ++p ){
+        PartitionSums& sums = partitionSums[p];
+        tsAdultEntoInocs += sums.adultEntoInocs;
+        tsNumAdults += sums.numAdults;
+        for( size_t i = 0; i < surveyInoculations.size(); ++i ){
+            surveyInoculations[i] += sums.inoculations[i];
+        }
+        sums.adultEntoInocs = 0.0;
+        sums.numAdults = 0;
+        sums.inoculations.assign( sums.inoculations.size(), 0.0 );
+    }
+}
+
 void TransmissionModel::summarize () {
     mon::reportStatMF( mon::MVF_NUM_TRANSMIT, laggedKappa[sim::now().moduloSteps(laggedKappa.size())] );
     mon::reportStatMF( mon::MVF_ANN_AVG_K, _annualAverageKappa );
@@ -247,6 +285,10 @@ void TransmissionModel::summarize () {
     lastSurveyTime = sim::now();
 }
 
+void TransmissionModel::resetSurveyInoculations () {
+    surveyInoculations.assign( survInocsSize(nSurveyGenotypes), 0.0 );
+}
+
 
 // -----  checkpointing  -----
 
@@ -110,6 +110,11 @@ public:
    * Overriding functions should call this base version too. */
   virtual void summarize ();
   
+  /** Clear inoculations accumulated for the next survey and resize for the
+   * current monitoring age groups and cohorts. Used after loading a warm-up
+   * snapshot, which may have been written with different monitoring. */
+  void resetSurveyInoculations ();
+  
   /** Scale the EIR used by the model.
    *
    * EIR is scaled in memory (so will affect this simulation).
@@ -183,6 +188,12 @@ public:
   double getEIR (Host::Human& human, SimTime age, double ageYears,
                  vector<double>& EIR);
   
+  /** When humans are updated on several threads (see util::parallel),
+   * getEIR() accumulates into per-partition sums. This adds those into the
+   * model's own accumulators in partition order; call after each
+   * partitioned update. */
+  void mergePartitions ();
+  
   /** Non-vector model: throw an exception. Vector model: check that the
    * simulation mode allows interventions, and return a map of species names
    * to indecies. Each index must be unique and in the range [0,n) where
@@ -309,9 +320,23 @@ private:
   /// accumulator for time step adults requesting EIR
   int tsNumAdults;
   
+    /// Number of genotypes distinguished in surveyInoculations
+    size_t nSurveyGenotypes;
+    
     /// Total inoculations since last survey (multidimensional).
     /// See survInocsSize, survInocsIndex in cpp file.
     vector<double> surveyInoculations;
+    
+    /// Accumulators used by getEIR() for one partition of a multi-threaded
+    /// human update.
+    struct PartitionSums {
+        double adultEntoInocs;
+        int numAdults;
+        vector<double> inoculations;
+    };
+    /// One per partition when using several threads, otherwise empty.
+    /// Zero between updates, hence not checkpointed.
+    vector<PartitionSums> partitionSums;
 };
 
 } }
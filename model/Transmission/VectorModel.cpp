@@ -32,6 +32,7 @@
 #include <map>
 #include <cmath>
 #include <set>
+#include <iterator>
 
 namespace OM {
 namespace Transmission {
@@ -78,34 +79,29 @@ void VectorModel::ctsCbS_v (ostream& stream) {
     for(size_t i = 0; i < numSpecies; ++i)
         stream << '\t' << species[i].getLastVecStat(Anopheles::SV);
 }
+// Sum of the values for species i in a HostTraits array
+inline double sumOverHosts( const vector<double>& values, size_t i, size_t n ){
+    double total = 0.0;
+    for( size_t j = i * n, end = j + n; j < end; ++j )
+        total += values[j];
+    return total;
+}
 void VectorModel::ctsCbAlpha (const Population& population, ostream& stream){
+    ctsHostTraits( population );
     for( size_t i = 0; i < numSpecies; ++i){
-        const Anopheles::PerHostBase& params = species[i].getHumanBaseParams();
-        double total = 0.0;
-        for(Population::ConstIter iter = population.cbegin(); iter != population.cend(); ++iter) {
-            total += iter->perHostTransmission.entoAvailabilityFull( params, i, iter->age(sim::now()).inYears() );
-        }
-        stream << '\t' << total / population.size();
+        stream << '\t' << sumOverHosts( hostTraits.avail, i, hostTraits.numHumans ) / population.size();
     }
 }
 void VectorModel::ctsCbP_B (const Population& population, ostream& stream){
+    ctsHostTraits( population );
     for( size_t i = 0; i < numSpecies; ++i){
-	const Anopheles::PerHostBase& params = species[i].getHumanBaseParams();
-        double total = 0.0;
-        for(Population::ConstIter iter = population.cbegin(); iter != population.cend(); ++iter) {
-            total += iter->perHostTransmission.probMosqBiting( params, i );
-        }
-        stream << '\t' << total / population.size();
+        stream << '\t' << sumOverHosts( hostTraits.probBiting, i, hostTraits.numHumans ) / population.size();
     }
 }
 void VectorModel::ctsCbP_CD (const Population& population, ostream& stream){
+    ctsHostTraits( population );
     for( size_t i = 0; i < numSpecies; ++i){
-	const Anopheles::PerHostBase& params = species[i].getHumanBaseParams();
-        double total = 0.0;
-        for(Population::ConstIter iter = population.cbegin(); iter != population.cend(); ++iter) {
-            total += iter->perHostTransmission.probMosqResting( params, i );
-        }
-        stream << '\t' << total / population.size();
+        stream << '\t' << sumOverHosts( hostTraits.probResting, i, hostTraits.numHumans ) / population.size();
     }
 }
 void VectorModel::ctsNetInsecticideContent (const Population& population, ostream& stream){
@@ -163,7 +159,7 @@ const string& reverseLookup (const map<string,size_t>& m, size_t i) {
 VectorModel::VectorModel (const scnXml::Entomology& entoData,
                           const scnXml::Vector vectorData, int populationSize) :
     TransmissionModel( entoData, WithinHost::Genotypes::N() ),
-    initIterations(0), numSpecies(0)
+    initIterations(0), numSpecies(0), ctsTraitsTime(sim::never())
 {
     // Each item in the AnophelesSequence represents an anopheles species.
     // TransmissionModel::createTransmissionModel checks length of list >= 1.
@@ -407,10 +403,39 @@ void VectorModel::vectorUpdate (const Population& population) {
             popProbTransmission.at(i,g) = k;
         }
     }
+    // Availability relative to age at end of time step (see advancePeriod)
+    fillHostTraits( population, sim::ts1() );
+    ctsTraitsTime = sim::never();   // humans will change before reporting
     for(size_t i = 0; i < numSpecies; ++i){
-        species[i].advancePeriod (population, popProbTransmission, i, simulationMode == dynamicEIR);
+        species[i].advancePeriod (hostTraits, popProbTransmission, i, simulationMode == dynamicEIR);
     }
 }
+
+void VectorModel::fillHostTraits (const Population& population, SimTime ageTime) {
+    const size_t n = std::distance( population.cbegin(), population.cend() );
+    hostTraits.numHumans = n;
+    hostTraits.avail.resize( numSpecies * n );
+    hostTraits.probBiting.resize( numSpecies * n );
+    hostTraits.probResting.resize( numSpecies * n );
+    size_t i = 0;
+    for( Population::ConstIter h = population.cbegin(); h != population.cend(); ++h, ++i ){
+        const PerHost& host = h->perHostTransmission;
+        // age factor is the same for all species
+        const double ageFactor = host.relativeAvailabilityAge( h->age(ageTime).inYears() );
+        for( size_t s = 0; s < numSpecies; ++s ){
+            const Anopheles::PerHostBase& base = species[s].getHumanBaseParams();
+            const size_t j = s * n + i;
+            hostTraits.avail[j] = host.entoAvailabilityHetVecItv( base, s ) * ageFactor;
+            hostTraits.probBiting[j] = host.probMosqBiting( base, s );
+            hostTraits.probResting[j] = host.probMosqResting( base, s );
+        }
+    }
+}
+void VectorModel::ctsHostTraits (const Population& population) {
+    if( ctsTraitsTime == sim::now() ) return;
+    fillHostTraits( population, sim::now() );
+    ctsTraitsTime = sim::now();
+}
 void VectorModel::update( const Population& population ) {
     TransmissionModel::updateKappa( population );
 }
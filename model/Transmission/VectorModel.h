@@ -80,6 +80,14 @@ private:
     /** Return the mean availability of human population to mosquitoes. */
     static double meanPopAvail (const Population& population);
     
+    /** Fill hostTraits from the population, in one pass over humans.
+     * 
+     * @param ageTime Time at which to evaluate humans' ages */
+    void fillHostTraits (const Population& population, SimTime ageTime);
+    /** Make hostTraits valid for continuous reporting at sim::now(). Only
+     * the first callback reporting at a given time needs to fill it. */
+    void ctsHostTraits (const Population& population);
+    
   void ctsCbN_v0 (ostream& stream);
   void ctsCbP_A (ostream& stream);
   void ctsCbP_df (ostream& stream);
@@ -126,6 +134,12 @@ private:
   map<string,size_t> speciesIndex;
   //@}
   
+  /** Per-human factors, filled each time step by vectorUpdate() and (if
+   * needed) again for continuous reporting. Not checkpointed. */
+  Anopheles::HostTraits hostTraits;
+  /// Time hostTraits was filled for continuous reporting, or sim::never()
+  SimTime ctsTraitsTime;
+  
   friend class PerHost;
   friend class AnophelesModelSuite;
 };
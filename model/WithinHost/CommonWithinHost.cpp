@@ -27,6 +27,7 @@
 #include "util/AgeGroupInterpolation.h"
 #include "util/random.h"
 #include "util/StreamValidator.h"
+#include "util/parallel.h"
 #include "schema/scenario.h"
 
 #include <boost/algorithm/string.hpp>
@@ -88,7 +89,7 @@ CommonWithinHost::CommonWithinHost( double comorbidityFactor ) :
 }
 
 CommonWithinHost::~CommonWithinHost() {
-    for( list<CommonInfection*>::iterator inf = infections.begin(); inf != infections.end(); ++inf ){
+    for( InfectionVec::iterator inf = infections.begin(); inf != infections.end(); ++inf ){
         delete *inf;
     }
     infections.clear();
@@ -97,7 +98,7 @@ CommonWithinHost::~CommonWithinHost() {
 // -----  Simple infection adders/removers  -----
 
 void CommonWithinHost::clearInfections( Treatments::Stages stage ){
-    for(std::list<CommonInfection*>::iterator inf = infections.begin(); inf != infections.end();) {
+    for(InfectionVec::iterator inf = infections.begin(); inf != infections.end();) {
         if( stage == Treatments::BOTH ||
             (stage == Treatments::LIVER && !(*inf)->bloodStage()) ||
             (stage == Treatments::BLOOD && (*inf)->bloodStage())
@@ -118,7 +119,7 @@ void CommonWithinHost::treatPkPd(size_t schedule, size_t dosages, double age){
     pkpdModel.prescribe( schedule, dosages, age, mass );
 }
 void CommonWithinHost::clearImmunity() {
-    for(std::list<CommonInfection*>::iterator inf = infections.begin(); inf != infections.end(); ++inf) {
+    for(InfectionVec::iterator inf = infections.begin(); inf != infections.end(); ++inf) {
         (*inf)->clearImmunity();
     }
     m_cumulative_h = 0.0;
@@ -147,15 +148,15 @@ void CommonWithinHost::update(int nNewInfs, vector<double>& genotype_weights,
     // Cache total density for infectiousness calculations
     int y_lag_i = sim::ts0().moduloSteps(y_lag_len);
     for( size_t g = 0; g < Genotypes::N(); ++g ) m_y_lag.at(y_lag_i, g) = 0.0;
-    for( std::list<CommonInfection*>::iterator inf = infections.begin(); inf != infections.end(); ++inf ){
+    for( InfectionVec::iterator inf = infections.begin(); inf != infections.end(); ++inf ){
         m_y_lag.at( y_lag_i, (*inf)->genotype() ) += (*inf)->getDensity();
     }
     
     // Note: adding infections at the beginning of the update instead of the end
     // shouldn't be significant since before latentp delay nothing is updated.
-    PopulationStats::totalInfections += nNewInfs;
+    util::parallel::atomicAdd( PopulationStats::totalInfections, nNewInfs );
     nNewInfs=min(nNewInfs,MAX_INFECTIONS-numInfs);
-    PopulationStats::allowedInfections += nNewInfs;
+    util::parallel::atomicAdd( PopulationStats::allowedInfections, nNewInfs );
     numInfs += nNewInfs;
     assert( numInfs>=0 && numInfs<=MAX_INFECTIONS );
     for( int i=0; i<nNewInfs; ++i ) {
@@ -186,7 +187,7 @@ void CommonWithinHost::update(int nNewInfs, vector<double>& genotype_weights,
         
         double sumLogDens = 0.0;
         
-        for(std::list<CommonInfection*>::iterator inf = infections.begin(); inf != infections.end();) {
+        for(InfectionVec::iterator inf = infections.begin(); inf != infections.end();) {
             // Note: this is only one treatment model; there is also the PK/PD model
             bool expires = ((*inf)->bloodStage() ? treatmentBlood : treatmentLiver);
             
@@ -244,7 +245,7 @@ bool CommonWithinHost::summarize( const Host::Human& human )const{
     if( infections.size() > 0 ){
         mon::reportStatMHI( mon::MHR_INFECTED_HOSTS, human, 1 );
         if( reportInfectedOrPatentInfected ){
-            for(std::list<CommonInfection*>::const_iterator inf =
+            for(InfectionVec::const_iterator inf =
                 infections.begin(); inf != infections.end(); ++inf) {
                 uint32_t genotype = (*inf)->genotype();
                 mon::reportStatMHGI( mon::MHR_INFECTIONS, human, genotype, 1 );
@@ -305,7 +306,7 @@ void CommonWithinHost::checkpoint (ostream& stream) {
     WHFalciparum::checkpoint (stream);
     hetMassMultiplier & stream;
     pkpdModel & stream;
-    for(std::list<CommonInfection*>::iterator inf = infections.begin(); inf != infections.end(); ++inf) {
+    for(InfectionVec::iterator inf = infections.begin(); inf != infections.end(); ++inf) {
         (**inf) & stream;
     }
 }
@@ -84,9 +84,14 @@ private:
     /** The list of all infections this human has.
      *
      * Since infection models and within host models are very much intertwined,
-     * the idea is that each WithinHostModel has its own list of infections. */
+     * the idea is that each WithinHostModel has its own list of infections.
+     * 
+     * A vector, not a list: hosts carry few infections (at most
+     * MAX_INFECTIONS), so erasing from the middle is cheap, and this avoids
+     * allocating a node per infection. Order is preserved. */
     //TODO: better to template class over infection type than use dynamic type?
-    std::list<CommonInfection*> infections;
+    typedef vector<CommonInfection*> InfectionVec;
+    InfectionVec infections;
 };
 
 } }
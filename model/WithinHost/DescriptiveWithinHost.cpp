@@ -26,6 +26,7 @@
 #include "util/ModelOptions.h"
 #include "PopulationStats.h"
 #include "util/StreamValidator.h"
+#include "util/parallel.h"
 #include "util/errors.h"
 #include <cassert>
 
@@ -104,9 +105,9 @@ void DescriptiveWithinHostModel::update(int nNewInfs, vector<double>& genotype_w
     
     // Note: adding infections at the beginning of the update instead of the end
     // shouldn't be significant since before latentp delay nothing is updated.
-    PopulationStats::totalInfections += nNewInfs;
+    util::parallel::atomicAdd( PopulationStats::totalInfections, nNewInfs );
     nNewInfs=min(nNewInfs,MAX_INFECTIONS-numInfs);
-    PopulationStats::allowedInfections += nNewInfs;
+    util::parallel::atomicAdd( PopulationStats::allowedInfections, nNewInfs );
     numInfs += nNewInfs;
     assert( numInfs>=0 && numInfs<=MAX_INFECTIONS );
     for( int i=0; i<nNewInfs; ++i ) {
@@ -128,6 +129,9 @@ void DescriptiveWithinHostModel::update(int nNewInfs, vector<double>& genotype_w
     bool treatmentLiver = treatExpiryLiver > sim::ts0();
     bool treatmentBlood = treatExpiryBlood > sim::ts0();
     
+    const DescriptiveInfection::HostFactors host =
+        DescriptiveInfection::hostFactors(ageInYears, cumulative_h, cumulative_Y);
+    
     for(std::list<DescriptiveInfection>::iterator inf = infections.begin(); inf != infections.end();) {
         //NOTE: it would be nice to combine this code with that in
         // CommonWithinHost.cpp, but a few changes would be needed:
@@ -147,7 +151,7 @@ void DescriptiveWithinHostModel::update(int nNewInfs, vector<double>& genotype_w
         // Should be: infStepMaxDens = 0.0, but has some history.
         // See MAX_DENS_CORRECTION in DescriptiveInfection.cpp.
         double infStepMaxDens = timeStepMaxDensity;
-        inf->determineDensities(ageInYears, cumulative_h, cumulative_Y, infStepMaxDens, _innateImmSurvFact, bsvFactor);
+        inf->determineDensities(host, infStepMaxDens, _innateImmSurvFact, bsvFactor);
 
         if (bugfix_max_dens)
             infStepMaxDens = std::max(infStepMaxDens, timeStepMaxDensity);
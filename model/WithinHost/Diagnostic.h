@@ -41,6 +41,11 @@ public:
      * @returns True if outcome is positive. */
     bool isPositive( double dens ) const;
     
+    /// True if the test uses no random numbers (see isPositive).
+    inline bool isDeterministic() const{
+        return (boost::math::isnan)(specificity);
+    }
+    
     inline bool operator!=( const Diagnostic& that )const{
         return specificity != that.specificity ||
             dens_lim != that.dens_lim;
@@ -22,6 +22,7 @@
 #define Hmod_CommonInfection
 
 #include "WithinHost/Infection/Infection.h"
+#include "util/SlabPool.h"
 
 namespace OM { namespace WithinHost {
 
@@ -44,6 +45,14 @@ public:
 	m_genotype(genotype)
     {}
     virtual ~CommonInfection() {}
+    
+    /// Instances are allocated from slabs: infections start and clear often
+    static void* operator new( size_t size ){
+        return util::slab::allocate( size );
+    }
+    static void operator delete( void* p, size_t size ){
+        util::slab::deallocate( p, size );
+    }
     //@}
     
     /** Get the infection's genotype. */
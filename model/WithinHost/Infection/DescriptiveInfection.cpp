@@ -29,13 +29,15 @@
 #include <string>
 #include <cmath>
 #include <fstream>
+#include <vector>
 
 namespace OM {
 namespace WithinHost {
 using namespace util;
 
 // static class variables (see description in header file):
-double DescriptiveInfection::meanLogParasiteCount[numDurations][numDurations];
+double DescriptiveInfection::naiveDensity[numDurations * numDurations];
+double DescriptiveInfection::maxSampleExponent;
 double DescriptiveInfection::sigma0sq;
 double DescriptiveInfection::xNuStar;
 
@@ -62,6 +64,7 @@ void DescriptiveInfection::init (const Parameters& parameters) {
     // Read parameters
     sigma0sq=parameters[Parameters::SIGMA0_SQ];
     xNuStar=parameters[Parameters::X_NU_STAR];
+    maxSampleExponent = 1.0 / (sim::oneTS().inDays() - 1);
     
     // Read file empirical parasite densities
     string densities_filename = util::CommandLine::lookupResource ("densities.csv");
@@ -70,6 +73,9 @@ void DescriptiveInfection::init (const Parameters& parameters) {
         throw util::base_exception( string("Cannot read ").append(densities_filename), util::Error::FileIO );
     }
     
+    // Mean log parasite count; see naiveDensity
+    vector<double> meanLogParasiteCount( numDurations * numDurations, 0.0 );
+    
     //read header of file (unused)
     string csvLine;
     getline(f_MTherapyDensities,csvLine);
@@ -103,13 +109,18 @@ void DescriptiveInfection::init (const Parameters& parameters) {
         }
 
         //fill initial matrix
-        meanLogParasiteCount[i-1][j-1]=meanlogdens;
+        meanLogParasiteCount[(i-1)*numDurations + (j-1)]=meanlogdens;
         //fill also the triangle that will not be used (to ensure everything is initialised)
         if (j!=i) {
-            meanLogParasiteCount[j-1][i-1]=0.0;
+            meanLogParasiteCount[(j-1)*numDurations + (i-1)]=0.0;
         }
 
     }
+    
+    // Precompute the exp, which otherwise is done per infection per step
+    for( size_t k = 0; k < meanLogParasiteCount.size(); ++k ){
+        naiveDensity[k] = max( exp(meanLogParasiteCount[k]), 1.0 );
+    }
 }
 
 
@@ -140,9 +151,22 @@ SimTime DescriptiveInfection::infectionDuration() {
 
 // ———  time-step updates  ———
 
-void DescriptiveInfection::determineDensities(double ageInYears,
-                                              double cumulativeh,
-                                              double cumulativeY,
+DescriptiveInfection::HostFactors DescriptiveInfection::hostFactors(
+        double ageInYears, double cumulativeh, double cumulativeY)
+{
+    HostFactors host;
+    host.cumulativeh = cumulativeh;
+    host.cumulativeY = cumulativeY;
+    host.dA = maternalImmunityFactor(ageInYears);
+    
+    // Variance of the lognormal used to perturb densities
+    double varlog = sigma0sq / (1.0 + (cumulativeh / xNuStar));
+    host.stdlog = sqrt(varlog);
+    host.halfVarlog = host.stdlog*host.stdlog / 2.0;
+    return host;
+}
+
+void DescriptiveInfection::determineDensities(const HostFactors& host,
                                               double &timeStepMaxDensity,
                                               double innateImmSurvFact,
                                               double bsvFactor)
@@ -158,28 +182,27 @@ void DescriptiveInfection::determineDensities(double ageInYears,
         
         int32_t infAge = min( infage.inSteps(), maxDurationTS );
         int32_t infDur = min( m_duration.inSteps(), maxDurationTS );
-        m_density=max (exp(meanLogParasiteCount[infAge][infDur]), 1.0);
+        m_density = naiveDensity[infAge * numDurations + infDur];
         
         // The expected parasite density in the non naive host (AJTM p.9 eq. 9)
         // Note that in published and current implementations Dx is zero.
-        m_density = pow(m_density, immunitySurvivalFactor(ageInYears, cumulativeh, cumulativeY));
+        m_density = pow(m_density, immunitySurvivalFactorDm(host.dA, host.cumulativeh, host.cumulativeY));
         
         //Perturb m_density using a lognormal
-        double varlog = sigma0sq / (1.0 + (cumulativeh / xNuStar));
-        double stdlog = sqrt(varlog);
+        const double stdlog = host.stdlog;
         
         /*
         This code samples from a log normal distribution with mean equal to the predicted density
         n.b. AJTM p.9 eq 9 implies that we sample the log of the density from a normal with mean equal to
         the log of the predicted density.  If we really did the latter then this bias correction is not needed.
         */
-        double meanlog = log(m_density) - stdlog*stdlog / 2.0;
+        double meanlog = log(m_density) - host.halfVarlog;
         if (stdlog > 0.0000001) {
             // Calculate the expected density on the day of sampling:
             m_density = random::log_normal(meanlog, stdlog);
             // Calculate additional samples for T-1 days (T=sim::oneTS().inDays()):
             if( true /*was sim::oneTS().inDays() > 1, which is always true in this model*/ ){
-                double normp = pow( random::uniform_01(), 1.0 / (sim::oneTS().inDays() - 1) );
+                double normp = pow( random::uniform_01(), maxSampleExponent );
                 /*
                 To mimic sampling T-1 repeated values, we transform the sampling
                 distribution and use only one sampled value, which has the sampling
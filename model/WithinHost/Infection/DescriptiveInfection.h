@@ -40,7 +40,7 @@ const double maxDens = 2000000;
  * 
  * This model was designed primarily for usage with a 5-day time-step, but is
  * mostly applicable to 1-4 day time-steps too. In such cases the indexes used
- * to access meanLogParasiteCount (or the data contained) would need adjusting.
+ * to access naiveDensity (or the data contained) would need adjusting.
  * 
  * Note that this class models only a single infection; for the associated
  * handling of multiple infections see the DescriptiveWithinHostModel class.
@@ -73,19 +73,36 @@ public:
         return sim::ts0() > m_startDate + m_duration;
     }
     
-    /** Determines parasite density of an individual infection (5-day time step
-     * update)
+    /** Quantities used by determineDensities() which depend on the host but
+     * not the infection. Computed by hostFactors() once per host per time
+     * step, rather than once per infection. */
+    struct HostFactors {
+        double cumulativeh;     ///< Cumulative number of infections
+        double cumulativeY;     ///< Previous exposure (cumulative parasite density)
+        double dA;              ///< Maternal immunity term (see Infection::maternalImmunityFactor)
+        double stdlog;          ///< Standard deviation of log density (AJTM p.9 eq. 13)
+        double halfVarlog;      ///< stdlog^2 / 2, bias correction for the mean
+    };
+    
+    /** Compute host-level inputs to determineDensities().
      *
      * @param ageInYears Age (of human)
      * @param cumulativeh Cumulative number of infections
      * @param cumulativeY Previous exposure (cumulative parasite density)
+     */
+    static HostFactors hostFactors(double ageInYears, double cumulativeh,
+                                   double cumulativeY);
+    
+    /** Determines parasite density of an individual infection (5-day time step
+     * update)
+     *
+     * @param host Host-level factors, from hostFactors()
      * @param timeStepMaxDensity (In-out param) Used to return the maximum
      *  parasite density over a 5-day interval.
      * @param innateImmSurvFact Density multiplier for innate immunity.
      * @param bsvFactor Density multiplier for Blood-Stage Vaccine effect.
      */
-    void determineDensities(double ageInYears, double cumulativeh,
-                            double cumulativeY, double &timeStepMaxDensity,
+    void determineDensities(const HostFactors& host, double &timeStepMaxDensity,
                             double innateImmSurvFact, double bsvFactor);
     
     /** Decide on an infection duration and return it.
@@ -112,10 +129,14 @@ protected:
 private:
     /// @brief Static parameters set by init()
     //@{
-    /* A triangular matrix: meanLogParasiteCount[i][j] is the
-     * Mean Log Parasite Count for age i (in time steps) of an infection which
-     * lasts j days. Indices with i>j are unused. */
-    static double meanLogParasiteCount[numDurations][numDurations];
+    /* Expected density in a naive host, max(exp(m), 1) where m is the Mean
+     * Log Parasite Count from densities.csv. Flattened triangular matrix:
+     * element i*numDurations+j is for age i (in time steps) of an infection
+     * which lasts j time steps. Indices with i>j are unused. */
+    static double naiveDensity[numDurations * numDurations];
+    
+    /// Exponent 1/(T-1) used to sample the maximum of T-1 daily densities
+    static double maxSampleExponent;
     
     /// Sigma0^2 from AJTM p.9 eq. 13
     static double sigma0sq;
@@ -29,6 +29,7 @@
 #include <fstream>
 #include <string>
 #include <cmath>
+#include <gsl/gsl_cdf.h>
 
 
 namespace OM { namespace WithinHost {
@@ -56,6 +57,7 @@ double EmpiricalInfection::_inflationMean;
 double EmpiricalInfection::_inflationVariance;
 double EmpiricalInfection::_extinctionLevel;
 double EmpiricalInfection::_overallMultiplier;
+bool EmpiricalInfection::rejectionSampling = true;
 
 
 CommonInfection* createEmpiricalInfection (uint32_t protID) {
@@ -69,6 +71,7 @@ CommonInfection* checkpointedEmpiricalInfection (istream& stream) {
 void EmpiricalInfection::init(){
     CommonWithinHost::createInfection = &createEmpiricalInfection;
     CommonWithinHost::checkpointedInfection = &checkpointedEmpiricalInfection;
+    rejectionSampling = !util::CommandLine::option( util::CommandLine::EMPIRICAL_TRUNCATED_SAMPLING );
     
   // alpha1 corresponds to 1 day before first patent, alpha2 2 days before first patent etc.
   _alpha1=0.2647;
@@ -172,25 +175,9 @@ bool EmpiricalInfection::updateDensity( double survivalFactor, SimTime bsAge, do
   double localDensity;	// density before scaling by _overallMultiplier
   size_t ageDays = bsAge.inDays();
   for(int tries0 = 0; tries0 < EI_MAX_SAMPLES; ++tries0) {
-    double logDensity;
-    for(int tries1 = 0; tries1 < EI_MAX_SAMPLES; ++tries1) {
-      double b_1=random::gauss(_mu_beta1[ageDays],_sigma_beta1[ageDays]);
-      double b_2=random::gauss(_mu_beta2[ageDays],_sigma_beta2[ageDays]);
-      double b_3=random::gauss(_mu_beta3[ageDays],_sigma_beta3[ageDays]);
-      double expectedlogDensity = b_1 * (L[0]+L[1]+L[2]) / 3
-      + b_2 * (L[2]-L[0]) / 2
-      + b_3 * (L[2]+L[0]-2*L[1]) / 4;
-      
-      //include sampling error
-      logDensity=random::gauss(expectedlogDensity,sigma_noise(ageDays));
-      //include drug and immunity effects via growthRateMultiplier 
-      logDensity += log(_patentGrowthRateMultiplier);
-      
-      if (logDensity <= upperLimitoflogDensity)	//got an acceptable density, we're done
-	break;	// most of the time this should happen first try
-    }
-    if (!(logDensity <= upperLimitoflogDensity))	// in case all the above attempts fail, cap logDensity
-      logDensity=upperLimitoflogDensity;
+    double logDensity = rejectionSampling ?
+        sampleLogDensityRejection(ageDays, upperLimitoflogDensity) :
+        sampleLogDensity(ageDays, upperLimitoflogDensity);
     
     localDensity= getInflatedDensity(logDensity);
     
@@ -223,6 +210,61 @@ bool EmpiricalInfection::updateDensity( double survivalFactor, SimTime bsAge, do
 # undef L
 }
 
+void EmpiricalInfection::logDensityDistribution(size_t ageDays, double& mean, double& sd) const{
+  const double *L = _laggedLogDensities;
+  // expected log density is b_1*x1 + b_2*x2 + b_3*x3 with b_i independent normals
+  const double x1 = (L[0]+L[1]+L[2]) / 3;
+  const double x2 = (L[2]-L[0]) / 2;
+  const double x3 = (L[2]+L[0]-2*L[1]) / 4;
+  mean = _mu_beta1[ageDays] * x1 + _mu_beta2[ageDays] * x2 + _mu_beta3[ageDays] * x3
+      //include drug and immunity effects via growthRateMultiplier
+      + log(_patentGrowthRateMultiplier);
+  const double s1 = _sigma_beta1[ageDays] * x1;
+  const double s2 = _sigma_beta2[ageDays] * x2;
+  const double s3 = _sigma_beta3[ageDays] * x3;
+  const double sn = sigma_noise(ageDays);       // sampling error
+  sd = sqrt(s1*s1 + s2*s2 + s3*s3 + sn*sn);
+}
+
+double EmpiricalInfection::sampleLogDensity(size_t ageDays, double upperLimit) const{
+  double mean, sd;
+  logDensityDistribution(ageDays, mean, sd);
+  // probability that one draw does not exceed the limit
+  const double pAccept = gsl_cdf_gaussian_P(upperLimit - mean, sd);
+  if (!(pAccept > 0.0))	// also when NaN, which the loop never accepted
+    return upperLimit;
+  // probability that all tries of the rejection loop fail
+  const double pCap = pow(1.0 - pAccept, EI_MAX_SAMPLES);
+  if (random::uniform_01() < pCap)
+    return upperLimit;
+  // 1 - uniform_01() is in (0,1], so the quantile is finite
+  const double u = (1.0 - random::uniform_01()) * pAccept;
+  return std::min(mean + sd * gsl_cdf_ugaussian_Pinv(u), upperLimit);
+}
+
+double EmpiricalInfection::sampleLogDensityRejection(size_t ageDays, double upperLimit) const{
+  const double *L = _laggedLogDensities;
+  double logDensity;
+  for(int tries1 = 0; tries1 < EI_MAX_SAMPLES; ++tries1) {
+    double b_1=random::gauss(_mu_beta1[ageDays],_sigma_beta1[ageDays]);
+    double b_2=random::gauss(_mu_beta2[ageDays],_sigma_beta2[ageDays]);
+    double b_3=random::gauss(_mu_beta3[ageDays],_sigma_beta3[ageDays]);
+    double expectedlogDensity = b_1 * (L[0]+L[1]+L[2]) / 3
+    + b_2 * (L[2]-L[0]) / 2
+    + b_3 * (L[2]+L[0]-2*L[1]) / 4;
+    
+    //include sampling error
+    logDensity=random::gauss(expectedlogDensity,sigma_noise(ageDays));
+    //include drug and immunity effects via growthRateMultiplier 
+    logDensity += log(_patentGrowthRateMultiplier);
+    
+    if (logDensity <= upperLimit)	//got an acceptable density, we're done
+      return logDensity;	// most of the time this should happen first try
+  }
+  // in case all the above attempts fail, cap logDensity
+  return upperLimit;
+}
+
 double EmpiricalInfection::sampleSubPatentValue(double alpha, double mu, double upperBound){
     double beta = alpha * (1.0-mu) / mu;
     double nonInflatedValue = upperBound + log(random::beta(alpha, beta));
@@ -34,6 +34,13 @@ public:
   
   /// only for parameterisation?
   static void overrideInflationFactors(double inflationMean, double inflationVariance, double extinctionLevel, double overallMultiplier);
+  
+  /** If true, sample log densities with the original rejection loop instead
+   * of the truncated normal sampler. Both sample the same distribution, but
+   * consume random numbers differently; the loop reproduces results of older
+   * versions exactly. True unless --empirical-sampling=truncated is given
+   * (set by init()). */
+  static bool rejectionSampling;
   //@}
   
   /// @brief Construction and destruction
@@ -59,8 +66,25 @@ protected:
     virtual void checkpoint (ostream& stream);
     
 private:
+  /** Mean and standard deviation of the log density (before inflation)
+   * sampled by the auto-regressive model, including the uncertainty in the
+   * regression coefficients, but without the upper limit. */
+  void logDensityDistribution(size_t ageDays, double& mean, double& sd) const;
+  /** Sample the log density, constrained not to exceed upperLimit.
+   * 
+   * This samples the distribution of the original rejection loop: up to
+   * EI_MAX_SAMPLES draws from the distribution described by
+   * logDensityDistribution() are tried; if none is acceptable the result is
+   * upperLimit. Equivalently, the result is upperLimit with probability
+   * (1-p)^EI_MAX_SAMPLES, where p is the probability of one draw not
+   * exceeding upperLimit, otherwise a draw from the normal distribution
+   * truncated above at upperLimit, sampled by inverting the CDF. Cost is
+   * independent of p. */
+  double sampleLogDensity(size_t ageDays, double upperLimit) const;
+  /// The original rejection loop (see rejectionSampling)
+  double sampleLogDensityRejection(size_t ageDays, double upperLimit) const;
   double getInflatedDensity(double nonInflatedDensity);
-  double sigma_noise(int ageDays);
+  static double sigma_noise(int ageDays);
   double samplePatentValue(double mu, double sigma, double lowerBound);
   double sampleSubPatentValue(double mu, double sigma, double upperBound);
   
@@ -92,6 +116,8 @@ private:
   static double _extinctionLevel;
   static double _overallMultiplier;
   //@}
+  
+  friend class ::UnittestUtil;
 };
 
 } }
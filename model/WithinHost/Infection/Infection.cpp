@@ -43,13 +43,19 @@ void Infection::init (const OM::Parameters& parameters, SimTime latP) {
 
 
 double Infection::immunitySurvivalFactor (double ageInYears, double cumulativeh, double cumulativeY) {
+  return immunitySurvivalFactorDm (maternalImmunityFactor (ageInYears), cumulativeh, cumulativeY);
+}
+
+double Infection::maternalImmunityFactor (double ageInYears) {
+  return 1.0 - alpha_m * exp(-decayM * ageInYears);
+}
+
+double Infection::immunitySurvivalFactorDm (double dA, double cumulativeh, double cumulativeY) {
   //Documentation: AJTMH pp22-23
   //effect of cumulative Parasite density (named Dy in AJTM)
   double dY;
   //effect of number of infections experienced since birth (named Dh in AJTM)
   double dH;
-  //effect of age-dependent maternal immunity (named Dm in AJTM)
-  double dA;
   
   if (cumulativeh <= 1.0) {
     dY=1.0;
@@ -58,7 +64,6 @@ double Infection::immunitySurvivalFactor (double ageInYears, double cumulativeh,
     dH=1.0 / (1.0 + (cumulativeh-1.0) * invCumulativeHstar);
     dY=1.0 / (1.0 + (cumulativeY - m_cumulativeExposureJ) * invCumulativeYstar);
   }
-  dA = 1.0 - alpha_m * exp(-decayM * ageInYears);
   double ret = std::min(dY*dH*dA, 1.0);
   util::streamValidate( ret );
   return ret;
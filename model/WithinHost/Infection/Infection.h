@@ -75,6 +75,14 @@ public:
      * time step). */
     double immunitySurvivalFactor (double ageInYears, double cumulativeh, double cumulativeY);
     
+    /** As immunitySurvivalFactor(), but with the maternal immunity term
+     * already computed by maternalImmunityFactor(). That term depends only on
+     * the host's age, so it can be computed once per host and time step. */
+    double immunitySurvivalFactorDm (double dA, double cumulativeh, double cumulativeY);
+    
+    /// Effect of age-dependent maternal immunity (named Dm in AJTM)
+    static double maternalImmunityFactor (double ageInYears);
+    
     /// Resets immunity properties specific to the infection (should only be
     /// called along with clearImmunity() on within-host model).
     inline void clearImmunity(){
@@ -64,6 +64,11 @@ protected:
 private:
     double getVariantSpecificSummation(int i, double P_current);
     
+    /// Set nVariants and all variant data to zero
+    void clearVariants();
+    void checkpointVariants (istream& stream);
+    void checkpointVariants (ostream& stream);
+    
     // Note: we also have inherited parameters:
     // m_startDate is used to give the age here
     // m_density is equivalent to Pc in paper
@@ -78,21 +83,17 @@ private:
      * between the last positive day and the first positive day. */
     float Pc_star, Pm_star;
     
-    struct Variant {
-        // Initialise all variables to 0
-        Variant ();
-        
-        /// Checkpointing
-        void operator& (ostream& stream);
-        void operator& (istream& stream);
-        
-        float Pi1, Pi2;   // Pi(t+1), Pi(t+2): variant's i density (PRBC/μl blood)
-        float Si_summation;     // sum in eqn 6
-        // index: we use ((bsAge.inDays()/2) mod 4) for τ = t - δ_v respectively τ = t
-        float lagged_Pi[taus];   // Pi(τ) for τ ∈ {t - δ_v, ..., t - 2}
-    };
-    // variant-specific data; variants[i-1] corresponds to variant i in the paper
-    vector<Variant> variants;
+    /* Variant-specific data, stored as one array per quantity (rather than
+     * an array of per-variant structs) so that the loops over variants in
+     * updateDensity() can be vectorised. Index i corresponds to variant i+1
+     * in the paper. Only the first nVariants variants have been expressed;
+     * the data of the others is zero, which gives the same results as if
+     * P_i(τ) = 0 had been special-cased. */
+    uint32_t nVariants;
+    float Pi1[v], Pi2[v];   // Pi(t+1), Pi(t+2): variant's i density (PRBC/μl blood)
+    float Si_summation[v];  // sum in eqn 6
+    // lagged_Pi[τ][i]: Pi(τ) for τ ∈ {t - δ_v, ..., t - 2}, indexed as lagged_Pc
+    float lagged_Pi[taus][v];
     
     // allow unittest to access private vars
     friend class ::MolineauxInfectionSuite;
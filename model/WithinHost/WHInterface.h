@@ -25,6 +25,7 @@
 #include "WithinHost/Diagnostic.h"
 #include "WithinHost/Pathogenesis/State.h"
 #include "Parameters.h"
+#include "util/SlabPool.h"
 
 using namespace std;
 
@@ -89,6 +90,14 @@ public:
     //@{
     WHInterface();
     virtual ~WHInterface();
+    
+    /// Instances are allocated from slabs, one pool per derived type
+    static void* operator new( size_t size ){
+        return util::slab::allocate( size );
+    }
+    static void operator delete( void* p, size_t size ){
+        util::slab::deallocate( p, size );
+    }
 
     /// Checkpointing
     template<class S>
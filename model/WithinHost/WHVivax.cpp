@@ -304,7 +304,7 @@ WHVivax::~WHVivax(){
 double WHVivax::probTransmissionToMosquito( double tbvFactor, double *sumX )const{
     assert( WithinHost::Genotypes::N() == 1 );
     assert( sumX == 0 );
-    for(list<VivaxBrood>::const_iterator inf = infections.begin();
+    for(BroodList::const_iterator inf = infections.begin();
          inf != infections.end(); ++inf)
     {
         if( inf->isPatent() ){
@@ -325,7 +325,7 @@ bool WHVivax::summarize(const Host::Human& human) const{
     // (patent) infections are reported by genotype, even though we don't have
     // genotype in this model
     mon::reportStatMHGI( mon::MHR_INFECTIONS, human, 0, infections.size() );
-    for(list<VivaxBrood>::const_iterator inf = infections.begin();
+    for(BroodList::const_iterator inf = infections.begin();
          inf != infections.end(); ++inf) 
     {
         if (inf->isPatent()){
@@ -360,7 +360,7 @@ void WHVivax::update(int nNewInfs, vector<double>&,
     double oldpEvent = ( isnan(pEvent))? 1.0 : pEvent;
     // always use the first relapse probability for following relapses as a factor
     double oldpRelapseEvent = ( isnan(pFirstRelapseEvent))? 1.0 : pFirstRelapseEvent;
-    list<VivaxBrood>::iterator inf = infections.begin();
+    BroodList::iterator inf = infections.begin();
     while( inf != infections.end() ){
         if( treatmentLiver ) inf->treatmentLS();
         if( treatmentBlood ) inf->treatmentBS();        // clearnace due to treatment; no protection against reemergence
@@ -417,7 +417,7 @@ void WHVivax::update(int nNewInfs, vector<double>&,
 bool WHVivax::diagnosticResult( const Diagnostic& diagnostic ) const{
     //TODO(monitoring): this shouldn't ignore the diagnostic (especially since
     // it should always return true if diagnostic.density=0)
-    for(list<VivaxBrood>::const_iterator inf = infections.begin();
+    for(BroodList::const_iterator inf = infections.begin();
          inf != infections.end(); ++inf)
     {
         if (inf->isPatent())
@@ -452,7 +452,7 @@ void WHVivax::optionalPqTreatment( const Host::Human& human ){
     // Vivax, and PQ is not given without BS drugs. NOTE: this ignores drug failure.
     if (pReceivePQ > 0.0 && (ignoreNoPQ || !noPQ) && random::bernoulli(pReceivePQ)){
         if( random::bernoulli(effectivenessPQ) ){
-            for( list<VivaxBrood>::iterator it = infections.begin(); it != infections.end(); ++it ){
+            for( BroodList::iterator it = infections.begin(); it != infections.end(); ++it ){
                 it->treatmentLS();
             }
         }
@@ -475,7 +475,7 @@ bool WHVivax::treatSimple( const Host::Human& human, SimTime timeLiver, SimTime
             if( timeLiver >= sim::zero() ){
                 treatExpiryLiver = max( treatExpiryLiver, sim::nowOrTs1() + timeLiver );
             }else{
-                for( list<VivaxBrood>::iterator it = infections.begin(); it != infections.end(); ++it ){
+                for( BroodList::iterator it = infections.begin(); it != infections.end(); ++it ){
                     it->treatmentLS();
                 }
             }
@@ -487,7 +487,7 @@ bool WHVivax::treatSimple( const Host::Human& human, SimTime timeLiver, SimTime
     if( timeBlood != sim::zero() ){
         if( timeBlood < sim::zero() ){
             // legacy mode: retroactive clearance
-            for( list<VivaxBrood>::iterator it = infections.begin(); it != infections.end(); ++it ){
+            for( BroodList::iterator it = infections.begin(); it != infections.end(); ++it ){
                 it->treatmentBS();
             }
         }else{
@@ -521,7 +521,7 @@ void WHVivax::checkpoint(istream& stream){
 void WHVivax::checkpoint(ostream& stream){
     WHInterface::checkpoint(stream);
     infections.size() & stream;
-    for( list<VivaxBrood>::iterator it = infections.begin(); it != infections.end(); ++it ){
+    for( BroodList::iterator it = infections.begin(); it != infections.end(); ++it ){
         it->checkpoint( stream );
     }
     noPQ & stream;
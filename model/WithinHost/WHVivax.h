@@ -179,7 +179,9 @@ protected:
 private:
     WHVivax( const WHVivax& ) {}        // not copy constructible
     
-    list<VivaxBrood> infections;
+    /// List nodes come from slabs: broods start and finish often
+    typedef list<VivaxBrood, util::SlabAllocator<VivaxBrood> > BroodList;
+    BroodList infections;
     
     /* Is flagged as never getting PQ: this is a heteogeneity factor. Example:
      * Set to zero if everyone can get PQ, 0.5 if females can't get PQ and
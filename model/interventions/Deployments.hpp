@@ -28,6 +28,7 @@
 #include "Population.h"
 #include "Transmission/TransmissionModel.h"
 #include "util/random.h"
+#include "util/CommandLine.h"
 #include <schema/interventions.h>
 
 namespace OM { namespace interventions {
@@ -207,6 +208,24 @@ protected:
         intervention->deploy( human, method, vaccLimits );
     }
     
+    /** Deploy to each human in [first, last) independently with probability
+     * p, by skipping a geometric number of humans between recipients.
+     * 
+     * Selection uses the global random number stream and one draw per
+     * recipient (plus one), instead of one draw per human. */
+    void deploySkipping( Population::Iter first, Population::Iter last,
+                         double p, mon::Deploy::Method method ) const{
+        if( !(p > 0.0) ) return;
+        for( ;; ){
+            size_t skip = util::random::geometric( p );
+            if( skip >= static_cast<size_t>( last - first ) ) return;
+            first += skip;
+            util::random::HumanContext rngContext( first->rngStreams(), util::random::PURPOSE_DEPLOY );
+            deployToHuman( *first, method );
+            ++first;
+        }
+    }
+    
     double coverage;    // proportion coverage within group meeting above restrictions
     VaccineLimits vaccLimits;
     ComponentId subPop;      // ComponentId_pop if deployment is not restricted to a sub-population
@@ -242,13 +261,36 @@ public:
     }
     
     virtual void deploy (OM::Population& population) {
-        for(Population::Iter iter = population.begin(); iter != population.end(); ++iter) {
-            SimTime age = iter->age(sim::now());
-            if( age >= minAge && age < maxAge ){
-                if( subPop == interventions::ComponentId_pop || (iter->isInSubPop( subPop ) != complement) ){
-                    if( util::random::bernoulli( coverage ) ){
-                        deployToHuman( *iter, mon::Deploy::TIMED );
-                    }
+        Population::Iter first, last;   // eligible humans (in population order)
+        Population::HumanPop members;
+        if( subPop != interventions::ComponentId_pop && !complement ){
+            // sub-population members are found without a scan; this visits
+            // the same humans in the same order
+            population.subPopMembers( subPop, minAge, maxAge, members );
+            first = Population::Iter( members.begin() );
+            last = Population::Iter( members.end() );
+        }else{
+            population.ageRange( minAge, maxAge, first, last );
+        }
+        if( util::CommandLine::option( util::CommandLine::GEOMETRIC_DEPLOYMENT ) ){
+            if( !complement ){
+                deploySkipping( first, last, coverage, mon::Deploy::TIMED );
+            }else{
+                Population::HumanPop eligible;
+                for(Population::Iter iter = first; iter != last; ++iter) {
+                    if( !iter->isInSubPop( subPop ) )
+                        eligible.push_back( &*iter );
+                }
+                deploySkipping( Population::Iter( eligible.begin() ),
+                        Population::Iter( eligible.end() ), coverage, mon::Deploy::TIMED );
+            }
+            return;
+        }
+        for(Population::Iter iter = first; iter != last; ++iter) {
+            if( subPop == interventions::ComponentId_pop || (iter->isInSubPop( subPop ) != complement) ){
+                util::random::HumanContext rngContext( iter->rngStreams(), util::random::PURPOSE_DEPLOY );
+                if( util::random::bernoulli( coverage ) ){
+                    deployToHuman( *iter, mon::Deploy::TIMED );
                 }
             }
         }
@@ -293,17 +335,32 @@ public:
     
     virtual void deploy (OM::Population& population) {
         // Cumulative case: bring target group's coverage up to target coverage
-        vector<Host::Human*> unprotected;
+        Population::HumanPop unprotected;
         size_t total = 0;       // number of humans within age bound and optionally subPop
-        for(Population::Iter iter = population.begin(); iter != population.end(); ++iter) {
-            SimTime age = iter->age(sim::now());
-            if( age >= minAge && age < maxAge ){
-                if( subPop == interventions::ComponentId_pop || (iter->isInSubPop( subPop ) != complement) ){
-                    total+=1;
-                    if( !iter->isInSubPop(cumCovInd) )
-                        unprotected.push_back( &*iter );
-                }
-            }
+        Population::Iter first, last;
+        Population::HumanPop members;
+        if( subPop == interventions::ComponentId_pop ){
+            population.ageRange( minAge, maxAge, first, last );
+            total = last - first;
+            if( total == 0 ) return;
+            // Count those protected from the index first: often the target
+            // coverage is already met and no scan is needed.
+            population.subPopMembers( cumCovInd, minAge, maxAge, members );
+            if( static_cast<double>( members.size() ) / static_cast<double>( total ) >= coverage )
+                return;
+        }else if( !complement ){
+            population.subPopMembers( subPop, minAge, maxAge, members );
+            first = Population::Iter( members.begin() );
+            last = Population::Iter( members.end() );
+        }else{
+            population.ageRange( minAge, maxAge, first, last );
+        }
+        total = 0;
+        for(Population::Iter iter = first; iter != last; ++iter) {
+            if( complement && iter->isInSubPop( subPop ) ) continue;
+            total+=1;
+            if( !iter->isInSubPop(cumCovInd) )
+                unprotected.push_back( &*iter );
         }
         
         if( total == 0 ) return;        // no humans to deploy to; avoid divide by zero
@@ -314,9 +371,15 @@ public:
             // selected from the list unprotected.
             double additionalCoverage = (coverage - propProtected) / (1.0 - propProtected);
             cerr << "cum deployment: prop protected " << propProtected << "; additionalCoverage " << additionalCoverage << "; total " << total << endl;
-            for(vector<Host::Human*>::iterator iter = unprotected.begin();
+            if( util::CommandLine::option( util::CommandLine::GEOMETRIC_DEPLOYMENT ) ){
+                deploySkipping( Population::Iter( unprotected.begin() ),
+                        Population::Iter( unprotected.end() ), additionalCoverage, mon::Deploy::TIMED );
+                return;
+            }
+            for(Population::HumanPop::iterator iter = unprotected.begin();
                  iter != unprotected.end(); ++iter)
             {
+                util::random::HumanContext rngContext( (*iter)->rngStreams(), util::random::PURPOSE_DEPLOY );
                 if( util::random::uniform_01() < additionalCoverage ){
                     deployToHuman( **iter, mon::Deploy::TIMED );
                 }
@@ -403,27 +466,24 @@ public:
         return this->deployAge < that.deployAge;
     }
     
-    /** Apply filters and potentially deploy.
-     * 
-     * @returns false iff this deployment (and thus all later ones in the
-     *  ordered list) happens in the future. */
-    bool filterAndDeploy( Host::Human& human, const Population& population ) const{
-        SimTime age = human.age(sim::now());
-        if( deployAge > age ){
-            // stop processing continuous deployments for this
-            // human for now because remaining ones happen in the future
-            return false;
-        }else if( deployAge == age ){
-            if( begin <= sim::intervNow() && sim::intervNow() < end &&
-                ( subPop == interventions::ComponentId_pop ||
-                    (human.isInSubPop( subPop ) != complement)
-                ) &&
-                util::random::uniform_01() < coverage )     // RNG call should be last test
-            {
-                deployToHuman( human, mon::Deploy::CTS );
-            }
-        }//else: for some reason, a deployment age was missed; ignore it
-        return true;
+    /// Age at which humans receive this deployment
+    inline SimTime targetAge() const{ return deployAge; }
+    
+    /// True if the deployment is active at the current time
+    inline bool isActive() const{
+        return begin <= sim::intervNow() && sim::intervNow() < end;
+    }
+    
+    /** Apply filters and potentially deploy to a human who has just reached
+     * targetAge(). Only call while isActive(). */
+    void filterAndDeploy( Host::Human& human ) const{
+        if( ( subPop == interventions::ComponentId_pop ||
+                (human.isInSubPop( subPop ) != complement)
+            ) &&
+            util::random::uniform_01() < coverage )     // RNG call should be last test
+        {
+            deployToHuman( human, mon::Deploy::CTS );
+        }
     }
     
 #ifdef WITHOUT_BOINC
@@ -69,6 +69,7 @@ struct ComponentId{
     inline void operator& (istream& stream) { id & stream; }
     inline void operator& (ostream& stream) const{ id & stream; }
     inline bool operator== (const ComponentId that) const{ return id == that.id; }
+    inline bool operator!= (const ComponentId that) const{ return id != that.id; }
     inline bool operator< (const ComponentId that) const{ return id < that.id; }
     size_t id;
 };
@@ -161,6 +161,8 @@ void InterventionManager::init (const scnXml::Interventions& intervElt, OM::Popu
             hiComponent->setExpireAfter( expireAfter );
             humanComponents.push_back( hiComponent );
         }
+        // ids are now fixed: size per-human sub-population storage
+        Host::SubPopMembership::init( humanComponents.size() );
         
         // 2. Read the list of deployments
         for( scnXml::HumanInterventions::DeploymentConstIterator it =
@@ -437,15 +439,31 @@ void InterventionManager::deploy(OM::Population& population) {
     }
     
     // deploy continuous interventions
-    for( Population::Iter it = population.begin(); it != population.end(); ++it ){
-        uint32_t nextCtsDist = it->getNextCtsDist();
-        // deploy continuous interventions
-        while( nextCtsDist < continuous.size() )
-        {
-            if( !continuous[nextCtsDist].filterAndDeploy( *it, population ) )
-                break;  // deployment (and all remaining) happens in the future
-            nextCtsDist = it->incrNextCtsDist();
+    // Humans reach a target age together with the others born on the same
+    // date; since the population is ordered by date of birth, this cohort is
+    // found by binary search. Each group of deployments with equal target
+    // age is handled in turn, oldest first, so that humans are visited in
+    // population order and deployments in list order.
+    for( size_t groupEnd = continuous.size(); groupEnd > 0; ){
+        const SimTime age = continuous[groupEnd - 1].targetAge();
+        size_t groupBegin = groupEnd - 1;
+        bool anyActive = continuous[groupBegin].isActive();
+        while( groupBegin > 0 && continuous[groupBegin - 1].targetAge() == age ){
+            groupBegin -= 1;
+            anyActive = anyActive || continuous[groupBegin].isActive();
+        }
+        if( anyActive ){
+            Population::Iter first, last;
+            population.ageRange( age, age + sim::oneTS(), first, last );
+            for( Population::Iter it = first; it != last; ++it ){
+                util::random::HumanContext rngContext( it->rngStreams(), util::random::PURPOSE_DEPLOY );
+                for( size_t i = groupBegin; i < groupEnd; ++i ){
+                    if( continuous[i].isActive() )
+                        continuous[i].filterAndDeploy( *it );
+                }
+            }
         }
+        groupEnd = groupBegin;
     }
 }
 
@@ -64,6 +64,12 @@ class AgeGroup {
         return upperBound.size();
     }
     
+    /// Get the upper bound of age group i (exclusive).
+    static inline SimTime getUpperBound( size_t i ){
+        assert( i < upperBound.size() );
+        return upperBound[i];
+    }
+    
 private:
     size_t index;
     
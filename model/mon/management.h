@@ -43,13 +43,30 @@ void initSurveyTimes( const Parameters& parameters,
 /// Call after initialising interventions
 void initCohorts( const scnXml::Monitoring& monitoring );
 
+/** Open the output file when streaming output (see
+ * util::CommandLine::STREAM_OUTPUT). Call after initSurveyTimes and, when
+ * resuming from a checkpoint, before reading the checkpoint. */
+void initOutput( bool isCheckpoint );
+
 /// Call just before the start of the intervention period
 void initMainSim();
 
-/// Call after all data for some survey number has been provided
+/** Call after all data for some survey number has been provided.
+ * 
+ * When streaming output, this also writes surveys for which no more reports
+ * can be made, and releases their data. */
 void concludeSurvey();
 
-/// Write survey data to output.txt (or configured file)
+/** Store reports made while humans were updated on several threads (see
+ * util::parallel). Reports are buffered per partition during the update and
+ * merged here: integer counts are summed per partition (addition is exact),
+ * while floating-point reports are replayed in partition order, hence in the
+ * same order as a serial update. Results therefore match a serial update.
+ * Call after each partitioned update. */
+void mergePartitionReports();
+
+/// Write survey data to output.txt (or configured file). When streaming
+/// output, this writes remaining surveys and closes the file.
 void writeSurveyData();
 
 // Checkpointing
@@ -61,8 +78,35 @@ namespace internal{
     /// Call before start of simulation to set up outputs. Call initSurveyTimes first.
     void initReporting( const scnXml::Scenario& scenario );
     
-    // Write results to stream
+    /** Write the header of the output file. The text format has none.
+     * 
+     * The binary format (util::CommandLine::BINARY_OUTPUT) starts with the
+     * magic string "OMCOLBIN", then three uint32 values: format version (1),
+     * 0x01020304 (to show byte order; all numbers use the writer's native
+     * order) and the length of a text header. The text header has one
+     * tab-separated line per item: output measures (number, name and type),
+     * reported age groups (number and upper bound in days), cohort output
+     * numbers, species, number of genotypes and drugs.
+     * 
+     * Blocks follow, one per measure and survey. Each has int32 measure
+     * number, uint32 survey number, uint32 number of rows and uint8 type (0
+     * for int32, 1 for double), then columns: uint16 age group, uint32
+     * cohort, uint16 species, uint16 genotype, uint16 drug and the values.
+     * See util/readBinaryOutput.py. */
+    void writeHeader( std::ostream& stream );
+    
+    // Write results to stream (including the header)
     void write( std::ostream& stream );
+    // Write results of one survey to stream
+    void writeSurvey( std::ostream& stream, size_t survey );
+    // Write the special IMR output to stream (if enabled)
+    void writeIMR( std::ostream& stream );
+    // Discard stored data for surveys before survey (when streaming)
+    void releaseSurveys( size_t survey );
+    
+    // Checkpointing of output file position (defined in misc.cpp)
+    void checkpointOutput( std::ostream& stream );
+    void checkpointOutput( std::istream& stream );
     
     /** Get the output cohort set numeric identifier given the internal one
      * (as returned by Survey::updateCohortSet()). */
@@ -26,6 +26,7 @@
 #include "mon/AgeGroup.h"
 #include "mon/reporting.h"
 #include "interventions/InterventionManager.hpp"
+#include "Clinical/CaseManagementCommon.h"
 #include "util/BoincWrapper.h"
 #include "util/CommandLine.h"
 #include "util/errors.h"
@@ -57,11 +58,14 @@ namespace impl{
     // Constants or defined during init:
     size_t nSurveys = 0;        // number of reported surveys
     size_t nCohorts = 1;     // default: just the whole population
+    bool streamOutput = false;  // write surveys as completed (see CommandLine::STREAM_OUTPUT)
+    bool binaryOutput = false;  // columnar binary output (see internal::writeHeader)
     extern size_t surveyIndex;     // index in surveyTimes of next survey
     vector<SurveyTime> surveyTimes;     // times of surveys
 }
 
 void updateConditions();        // defined in mon.cpp
+void writeSurveys( bool all );  // defined below
 
 void initSurveyTimes( const OM::Parameters& parameters,
                    const scnXml::Scenario& scenario,
@@ -137,12 +141,14 @@ void initSurveyTimes( const OM::Parameters& parameters,
     }
     
     if( monitoring.getCohorts().present() ){
-        // this needs to be set early, but we can't set cohortSubPopIds until after InterventionManager is initialised
+        // this needs to be set early, but we can't set cohortSubPopBits until after InterventionManager is initialised
         impl::nCohorts = static_cast<uint32_t>(1) << monitoring.getCohorts().get().getSubPop().size();
     }
     
     mon::AgeGroup::init( monitoring );
 
+    impl::streamOutput = util::CommandLine::option( util::CommandLine::STREAM_OUTPUT );
+    impl::binaryOutput = util::CommandLine::option( util::CommandLine::BINARY_OUTPUT );
     internal::initReporting( scenario );
 }
 
@@ -170,6 +176,7 @@ void concludeSurvey(){
     updateConditions();
     impl::surveyIndex += 1;
     updateSurveyNumbers();
+    if( impl::streamOutput ) writeSurveys( false );
 }
 
 SimTime nextSurveyTime(){
@@ -179,34 +186,153 @@ SimTime finalSurveyTime(){
     return impl::surveyTimes[impl::surveyTimes.size()-1].time;
 }
 
+
+// ———  output  ———
+
+// When streaming output, the file we write to. Otherwise the whole file is
+// written by writeSurveyData().
+string outFilename;
+#ifndef WITHOUT_BOINC
+// At end of simulation, compress the output file (as Monitoring::Continuous
+// does, since gzstream doesn't support seeking, needed for checkpoint resume).
+string outCompressedName;
+#endif
+fstream outStream;
+// Last position in the file (as position minus start), for checkpointing.
+streamoff outStreamOff = 0;
+streampos outStreamStart;
+// Index in impl::surveyTimes of the next survey to write (when streaming)
+size_t outWriteIndex = 0;
+
+void setupOutputStream( ostream& stream ){
+    // This locale ensures uniform formatting of nans and infs on all platforms.
+    std::locale old_locale;
+    std::locale nfn_put_locale(old_locale, new boost::math::nonfinite_num_put<char>);
+    stream.imbue( nfn_put_locale );
+    
+    stream.width (0);
+    // For additional control:
+    // stream.precision (6);
+    // stream << scientific;
+}
+
+void initOutput( bool isCheckpoint ){
+    if( !impl::streamOutput ) return;
+    
+    outFilename = util::BoincWrapper::resolveFile(
+        util::CommandLine::getOutputName() );
+#ifndef WITHOUT_BOINC
+    // redirect output to a temporary file; copy and compress this to the
+    // final output at end of simulation
+    outCompressedName = outFilename;
+    outFilename = "output_temp.txt";
+#endif
+    setupOutputStream( outStream );
+    
+    if( isCheckpoint ){
+        // Resume writing to this file. Position is set when the checkpoint
+        // is read.
+        outStream.open( outFilename.c_str(), ios::binary|ios::ate|ios::in|ios::out );
+        if( outStream.fail() )
+            throw util::checkpoint_error( "mon: output resume error (no file)" );
+        outStream.seekp( 0, ios_base::beg );
+        outStreamStart = outStream.tellp();
+    }else{
+#ifndef WITHOUT_BOINC
+        if (util::BoincWrapper::fileExists(outFilename.c_str())){
+            // As in Monitoring::Continuous, don't overwrite existing files
+            throw util::base_exception(string("File ").append(outFilename).append(" exists!"),util::Error::FileExists);
+        }
+#endif
+        outStream.open( outFilename.c_str(), ios::binary|ios::out );
+        if( outStream.fail() )
+            throw util::base_exception( string("Unable to open ").append(outFilename), util::Error::FileIO );
+        outStreamStart = outStream.tellp();
+        internal::writeHeader( outStream );
+        outStream << flush;
+        outStreamOff = outStream.tellp() - outStreamStart;
+    }
+}
+
+// When streaming output, write concluded surveys and release their data.
+// 
+// Clinical episodes are reported to the survey during which they started, up
+// to the health-system memory later (see Clinical::Episode::expire), so unless
+// `all` is true we stop at the first survey which could still receive reports.
+void writeSurveys( bool all ){
+    const SimTime latest = sim::intervNow() - Clinical::healthSystemMemory - sim::oneTS();
+    for( ; outWriteIndex < impl::surveyIndex; ++outWriteIndex ){
+        const SurveyTime& survey = impl::surveyTimes[outWriteIndex];
+        if( !all && survey.time > latest ) break;
+        if( survey.isReported() ){
+            internal::writeSurvey( outStream, survey.num );
+            internal::releaseSurveys( survey.num + 1 );
+        }
+    }
+    outStream << flush;
+    outStreamOff = outStream.tellp() - outStreamStart;
+}
+
 void writeSurveyData ()
 {
+    if( impl::streamOutput ){
+        writeSurveys( true );
+        internal::writeIMR( outStream );
+        outStream.close();
+#ifndef WITHOUT_BOINC
+        if (util::BoincWrapper::fileExists(outCompressedName.c_str())){
+            throw util::base_exception(string("File ").append(outCompressedName).append(" exists!"),util::Error::FileExists);
+        }
+        ifstream origFile(outFilename.c_str());
+        if( !origFile.is_open() ){
+            throw util::base_exception(string("Temporary file ").append(outFilename).append(" not found!"),util::Error::FileIO);
+        }
+        ogzstream finalFile(outCompressedName.c_str());
+        finalFile << origFile.rdbuf();
+#endif
+        return;
+    }
+    
 #ifdef WITHOUT_BOINC
     ofstream outputFile;          // without boinc, use plain text (for easy reading)
 #else
     ogzstream outputFile;         // with, use gzip
 #endif
-    
-    // This locale ensures uniform formatting of nans and infs on all platforms.
-    std::locale old_locale;
-    std::locale nfn_put_locale(old_locale, new boost::math::nonfinite_num_put<char>);
-    outputFile.imbue( nfn_put_locale );
+    setupOutputStream( outputFile );
 
     string output_filename = util::BoincWrapper::resolveFile(
         util::CommandLine::getOutputName() );
     
     outputFile.open( output_filename.c_str(), std::ios::out | std::ios::binary );
     
-    outputFile.width (0);
-    // For additional control:
-    // outputFile.precision (6);
-    // outputFile << scientific;
-    
     internal::write( outputFile );
     
     outputFile.close();
 }
 
+void internal::checkpointOutput( ostream& stream ){
+    impl::streamOutput & stream;
+    if( !impl::streamOutput ) return;
+    outWriteIndex & stream;
+    outStreamOff & stream;
+}
+void internal::checkpointOutput( istream& stream ){
+    bool streamed;
+    streamed & stream;
+    if( streamed != impl::streamOutput ){
+        throw util::checkpoint_error( "mon: checkpoint and command line "
+            "disagree on use of --stream-output" );
+    }
+    if( !impl::streamOutput ) return;
+    outWriteIndex & stream;
+    outStreamOff & stream;
+    // We skip back to the last write-point, so anything written after the
+    // last checkpoint will be repeated:
+    outStream.seekp( outStreamOff, ios_base::beg );
+    if( outStream.fail() )
+        throw util::checkpoint_error( "mon: output resume error (bad pos/file)" );
+}
+
 
 // ———  AgeGroup  ———
 
@@ -238,7 +364,9 @@ void AgeGroup::update (SimTime age) {
 
 using interventions::ComponentId;
 vector<uint32_t> cohortSubPopNumbers;   // value is output number
-map<ComponentId,uint32_t> cohortSubPopIds;      // value is internal index (used above)
+// indexed by component; value is the component's bit in the internal cohort set
+// (index used above), or 0 if the component is not used in cohorts
+vector<uint32_t> cohortSubPopBits;
 
 bool notPowerOfTwo( uint32_t num ){
     for( uint32_t i = 0; i <= 21; ++i ){
@@ -257,8 +385,9 @@ void initCohorts( const scnXml::Monitoring& monitoring )
             end = monCohorts.getSubPop().end(); it != end; ++it )
         {
             ComponentId compId = interventions::InterventionManager::getComponentId( it->getId() );
-            bool inserted = cohortSubPopIds.insert( make_pair(compId,nextId) ).second;
-            if( !inserted ){
+            if( compId.id >= cohortSubPopBits.size() )
+                cohortSubPopBits.resize( compId.id + 1, 0 );
+            if( cohortSubPopBits[compId.id] != 0 ){
                 throw util::xml_scenario_error(
                     string("cohort specification uses sub-population \"").append(it->getId())
                     .append("\" more than once") );
@@ -268,6 +397,7 @@ void initCohorts( const scnXml::Monitoring& monitoring )
                     string( "cohort specification assigns sub-population \"").append(it->getId())
                     .append("\" a number which is not a power of 2 (up to 2^21)") );
             }
+            cohortSubPopBits[compId.id] = static_cast<uint32_t>(1) << nextId;
             cohortSubPopNumbers.push_back( it->getNumber() );
             nextId += 1;
         }
@@ -275,9 +405,8 @@ void initCohorts( const scnXml::Monitoring& monitoring )
 }
 
 uint32_t updateCohortSet( uint32_t old, ComponentId subPop, bool isMember ){
-    map<ComponentId,uint32_t>::const_iterator it = cohortSubPopIds.find( subPop );
-    if( it == cohortSubPopIds.end() ) return old;       // sub-pop not used in cohorts
-    uint32_t subPopId = static_cast<uint32_t>(1) << it->second;        // 1 bit positive
+    if( subPop.id >= cohortSubPopBits.size() ) return old;      // sub-pop not used in cohorts
+    uint32_t subPopId = cohortSubPopBits[subPop.id];    // 1 bit positive, or 0 if not used
     return (old & ~subPopId) | (isMember ? subPopId : 0);
 }
 
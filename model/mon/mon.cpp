@@ -27,10 +27,13 @@
 #include "Clinical/CaseManagementCommon.h"
 #include "Host/Human.h"
 #include "util/errors.h"
+#include "util/parallel.h"
 #include "schema/scenario.h"
 
 #include <typeinfo>
 #include <iostream>
+#include <sstream>
+#include <limits>
 #include <boost/format.hpp>
 
 namespace OM {
@@ -55,6 +58,20 @@ namespace impl {
     SimTime nextSurveyTime = sim::future();
     
     vector<Condition> conditions;
+    
+    extern bool streamOutput, binaryOutput;     // defined in misc.cpp
+}
+
+// Write x in native byte order (see internal::writeHeader)
+template<typename T>
+inline void writeBinary( ostream& stream, T x ){
+    stream.write( reinterpret_cast<const char*>(&x), sizeof(T) );
+}
+template<typename T>
+inline void writeBinary( ostream& stream, const vector<T>& column ){
+    if( column.empty() ) return;
+    stream.write( reinterpret_cast<const char*>(&column[0]),
+                  column.size() * sizeof(T) );
 }
 
 /// One of these is used for every output index, and is specific to a measure
@@ -164,6 +181,53 @@ struct MonIndex {
             } } }
         }
     }
+    
+    // Write out some data from results in the columnar binary format (see
+    // internal::writeHeader). Parameters are as for write().
+    // 
+    // This writes one block: a header (output measure, survey number, number
+    // of rows and value type), then one column per category and the values.
+    // Unused categories are written as 0; other categories use the same
+    // numbers as the text format.
+    template<typename T>
+    void writeBinary( ostream& stream, int surveyNum, const OutMeasure& om,
+            const vector<T>& results, size_t surveyStart ) const
+    {
+        assert(results.size() >= surveyStart + size());
+        // Number of *reported* age categories, as in write()
+        size_t nAgeCats = nAges == 1 ? 1 : nAges - 1;
+        const size_t nRows = nAgeCats * nCohorts * nSpecies * nGenotypes * nDrugs;
+        vector<uint16_t> ageCol, speciesCol, genotypeCol, drugCol;
+        vector<uint32_t> cohortCol;
+        vector<T> valueCol;
+        ageCol.reserve( nRows ); cohortCol.reserve( nRows );
+        speciesCol.reserve( nRows ); genotypeCol.reserve( nRows );
+        drugCol.reserve( nRows ); valueCol.reserve( nRows );
+        for( size_t cohortSet = 0; cohortSet < nCohorts; ++cohortSet ){
+        for( size_t ageGroup = 0; ageGroup < nAgeCats; ++ageGroup ){
+        for( size_t species = 0; species < nSpecies; ++species ){
+        for( size_t genotype = 0; genotype < nGenotypes; ++genotype ){
+        for( size_t drug = 0; drug < nDrugs; ++drug ){
+            ageCol.push_back( om.byAge ? ageGroup + 1 : 0 );
+            cohortCol.push_back( internal::cohortSetOutputId( cohortSet ) );
+            speciesCol.push_back( om.bySpecies ? species + 1 : 0 );
+            genotypeCol.push_back( genotype );
+            drugCol.push_back( om.byDrug ? drug + 1 : 0 );
+            valueCol.push_back( results[surveyStart +
+                    index(ageGroup, cohortSet, species, genotype, drug)] );
+        } } } } }
+        
+        mon::writeBinary<int32_t>( stream, om.outId );
+        mon::writeBinary<uint32_t>( stream, surveyNum );
+        mon::writeBinary<uint32_t>( stream, nRows );
+        mon::writeBinary<uint8_t>( stream, typeid(T) == typeid(double) ? 1 : 0 );
+        mon::writeBinary( stream, ageCol );
+        mon::writeBinary( stream, cohortCol );
+        mon::writeBinary( stream, speciesCol );
+        mon::writeBinary( stream, genotypeCol );
+        mon::writeBinary( stream, drugCol );
+        mon::writeBinary( stream, valueCol );
+    }
 };
 
 struct MonIndByMeasure{
@@ -177,7 +241,7 @@ struct MonIndByMeasure{
 template<typename T>
 class Store{
 public:
-    Store() : surveySize(0) {}
+    Store() : surveySize(0), firstSurvey(0) {}
     
 private:
     // This lists all enabled outputs, sorted by `measure` (first field, of
@@ -190,14 +254,188 @@ private:
     typedef pair<uint16_t, uint16_t> MeasureRange;
     vector<MeasureRange> measure_map;
     
+    // Dispatch tables used by report() and deploy(), built by
+    // sortEnabledMeasures(). Table 0 lists, for each measure, where
+    // non-deployment reports are stored; tables 1-3 where deployments by each
+    // method are stored (see dispatchTable()). Each entry has the offset of
+    // a MonIndex and strides for each category, zero where not categorised,
+    // so that the index is a sum of products as in MonIndex::index(). Debug
+    // builds also keep the numbers of categories to check indices.
+    struct Target {
+        size_t offset;
+        size_t age, cohort, species, genotype, drug;
+#ifndef NDEBUG
+        size_t nAges, nCohorts, nSpecies, nGenotypes, nDrugs;
+#endif
+    };
+    enum { NUM_TABLES = 4 };
+    vector<Target> targets[NUM_TABLES];
+    // Per table, for each measure the range of entries in targets
+    vector<MeasureRange> dispatch[NUM_TABLES];
+    
+    static inline size_t dispatchTable( Deploy::Method method ){
+        return method == Deploy::TREAT ? 3 : static_cast<size_t>( method );
+    }
+    
     // Number of indices in `reports` used by a single survey
     size_t surveySize;
-    // These are the stored reports (multidimensional; size is `size()` and
-    // indices are `survey * surveySize + measures[m].index(...)` for some `m`).
+    // Number of the first survey held in `reports`. This is always zero
+    // unless streaming output, in which case surveys are released once written.
+    size_t firstSurvey;
+    // These are the stored reports (multidimensional; indices are
+    // `surveyOffset(survey) + measures[m].index(...)` for some `m`).
     vector<T> reports;
     
-    // get size of reports
-    inline size_t size(){ return surveySize * impl::nSurveys; }
+    // get initial size of reports: all surveys, or none when streaming output
+    // (then surveys are allocated as reports are made)
+    inline size_t size(){
+        return impl::streamOutput ? 0 : surveySize * impl::nSurveys;
+    }
+    
+    // get index in reports of the first value of some survey
+    inline size_t surveyOffset( size_t survey ){
+        if( survey < firstSurvey ){
+            throw TRACED_EXCEPTION_DEFAULT( "mon: report to a survey already written" );
+        }
+        const size_t off = (survey - firstSurvey) * surveySize;
+        if( off + surveySize > reports.size() ){
+            assert( impl::streamOutput );
+            reports.resize( off + surveySize, 0 );
+        }
+        return off;
+    }
+    
+    // Reports made during a partitioned update (see util::parallel) are
+    // buffered per partition and stored by mergePending(). Integer values are
+    // summed into buffers with the layout of one survey in `reports`; since
+    // integer addition is exact, the order of merging does not matter.
+    // Floating-point values are instead recorded individually and replayed in
+    // the order a serial update would make them, so that sums are identical.
+    static const bool sumInBuffers = std::numeric_limits<T>::is_integer;
+    
+    // Accumulates values for one survey. `touched` lists indices which may be
+    // non-zero (possibly repeated), so that merging and clearing need not
+    // scan the whole slice.
+    struct Slice {
+        Slice() : survey(NOT_USED) {}
+        
+        size_t survey;  // NOT_USED when free
+        vector<T> values;
+        vector<size_t> touched;
+        
+        inline void add( size_t index, T val ){
+            assert( index < values.size() );
+            if( values[index] == 0 ) touched.push_back( index );
+            values[index] += val;
+        }
+    };
+    // Adds directly to the values of one survey in `reports`
+    struct Direct {
+        T *values;
+        inline void add( size_t index, T val ){
+            values[index] += val;
+        }
+    };
+    // Per partition, slices allocated so far (reused between updates)
+    vector<vector<Slice> > buffers;
+    
+    // Get the buffer for survey in the current partition
+    Slice& buffer( size_t survey ){
+        vector<Slice>& slices = buffers[util::parallel::partition()];
+        Slice *free = 0;
+        for( size_t i = 0; i < slices.size(); ++i ){
+            if( slices[i].survey == survey ) return slices[i];
+            if( slices[i].survey == NOT_USED && free == 0 ) free = &slices[i];
+        }
+        if( free == 0 ){
+            slices.push_back( Slice() );
+            free = &slices.back();
+            free->values.assign( surveySize, 0 );
+        }
+        free->survey = survey;
+        return *free;
+    }
+    
+    // Add val to all entries for `measure` which accept it: if `method` is
+    // Deploy::NA those not tracking deployments, otherwise those tracking
+    // this type of deployment. If some of ageIndex, cohortSet, species are
+    // not applicable, use 0.
+    template<class Sink>
+    inline void store( Sink& sink, T val, const vector<Target>& table,
+                MeasureRange range, size_t ageIndex, uint32_t cohortSet,
+                size_t species, size_t genotype, size_t drug )
+    {
+        for( size_t i = range.first; i < range.second; ++i ){
+            const Target& t = table[i];
+            assert( (t.age == 0 || ageIndex < t.nAges) &&
+                    (t.cohort == 0 || cohortSet < t.nCohorts) &&
+                    (t.species == 0 || species < t.nSpecies) &&
+                    (t.genotype == 0 || genotype < t.nGenotypes) &&
+                    (t.drug == 0 || drug < t.nDrugs) );
+            const size_t index = t.offset + ageIndex * t.age +
+                cohortSet * t.cohort + species * t.species +
+                genotype * t.genotype + drug * t.drug;
+            assert( index < surveySize );
+            sink.add( index, val );
+        }
+    }
+    
+    // Store a value now or, during a partitioned update, buffer it
+    inline void add( T val, Measure measure, Deploy::Method method,
+                size_t survey, size_t ageIndex, uint32_t cohortSet,
+                size_t species, size_t genotype, size_t drug )
+    {
+        assert( measure < M_NUM );
+        const size_t tableIndex = dispatchTable( method );
+        const MeasureRange range = dispatch[tableIndex][measure];
+        if( range.first == range.second ) return;       // not recorded
+        const vector<Target>& table = targets[tableIndex];
+        if( util::parallel::active() ){
+            if( sumInBuffers ){
+                store( buffer(survey), val, table, range, ageIndex,
+                       cohortSet, species, genotype, drug );
+            }else{
+                defer( val, measure, survey, ageIndex, cohortSet, species,
+                       genotype, drug, method );
+            }
+            return;
+        }
+        Direct direct;
+        direct.values = &reports[surveyOffset(survey)];
+        store( direct, val, table, range, ageIndex, cohortSet, species,
+               genotype, drug );
+    }
+    
+    // A report made during a partitioned update, when not summing in buffers.
+    // `method` is Deploy::NA for report() and the method for deploy().
+    struct Pending {
+        T val;
+        Measure measure;
+        size_t survey, ageIndex;
+        uint32_t cohortSet;
+        size_t species, genotype, drug;
+        Deploy::Method method;
+    };
+    // Reports made during a partitioned update, per partition in the order
+    // made. Always empty outside of a partitioned update.
+    vector<vector<Pending> > pending;
+    
+    void defer( T val, Measure measure, size_t survey, size_t ageIndex,
+                uint32_t cohortSet, size_t species, size_t genotype, size_t drug,
+                Deploy::Method method )
+    {
+        Pending r;
+        r.val = val;
+        r.measure = measure;
+        r.survey = survey;
+        r.ageIndex = ageIndex;
+        r.cohortSet = cohortSet;
+        r.species = species;
+        r.genotype = genotype;
+        r.drug = drug;
+        r.method = method;
+        pending[util::parallel::partition()].push_back( r );
+    }
     
 public:
     // Set up ready to accept reports. The passed list includes all measures
@@ -227,6 +465,8 @@ public:
         // Leave a few spare slots for potential conditions using variables not already reported:
         reports.reserve(size() + 12);
         reports.assign(size(), 0);
+        pending.resize( util::parallel::numThreads() );
+        buffers.resize( util::parallel::numThreads() );
     }
     
     // Enable reporting by an additional measure, which does not categorise.
@@ -266,6 +506,7 @@ public:
     }
     
     // Sort measures, then fix the offsets and surveySize, then set measure_map
+    // and the dispatch tables
     void sortEnabledMeasures() {
         std::sort( measures.begin(), measures.end(), monIndByMeasure );
         measure_map.assign(M_NUM, make_pair(0, 0));
@@ -281,6 +522,49 @@ public:
                 measure_map[m].first = i;
             measure_map[m].second = i + 1;
         }
+        
+        for( size_t t = 0; t < NUM_TABLES; ++t ){
+            targets[t].clear();
+            dispatch[t].assign( M_NUM, make_pair(0, 0) );
+        }
+        // measures is sorted by measure, so entries for each are contiguous
+        foreach( const MonIndex& ind, measures ){
+            Target target;
+            target.offset = ind.offset;
+#ifndef NDEBUG
+            target.nAges = ind.nAges;
+            target.nCohorts = ind.nCohorts;
+            target.nSpecies = ind.nSpecies;
+            target.nGenotypes = ind.nGenotypes;
+            target.nDrugs = ind.nDrugs;
+#endif
+            size_t stride = 1;
+            target.drug = ind.nDrugs > 1 ? stride : 0;
+            stride *= ind.nDrugs;
+            target.genotype = ind.nGenotypes > 1 ? stride : 0;
+            stride *= ind.nGenotypes;
+            target.species = ind.nSpecies > 1 ? stride : 0;
+            stride *= ind.nSpecies;
+            target.cohort = ind.nCohorts > 1 ? stride : 0;
+            stride *= ind.nCohorts;
+            target.age = ind.nAges > 1 ? stride : 0;
+            
+            for( size_t t = 0; t < NUM_TABLES; ++t ){
+                // table 0 accepts non-deployment reports, others deployments
+                // by method 1 << (t - 1)
+                const bool accepts = t == 0 ? ind.deployMask == Deploy::NA :
+                    (ind.deployMask & (1 << (t - 1))) != 0;
+                if( !accepts ) continue;
+                // never used for deployments:
+                assert( t == 0 || (ind.nSpecies == 1 && ind.nGenotypes == 1) );
+                MeasureRange& range = dispatch[t][ind.measure];
+                if( range.first == range.second ){
+                    range.first = targets[t].size();
+                }
+                targets[t].push_back( target );
+                range.second = targets[t].size();
+            }
+        }
     }
     
     // Take a reported value and either store it or forget it.
@@ -289,20 +573,8 @@ public:
                  uint32_t cohortSet, size_t species, size_t genotype, size_t drug )
     {
         if( survey == NOT_USED ) return; // pre-main-sim & unit tests we ignore all reports
-        assert(measure < measure_map.size());
-        for( size_t i = measure_map[measure].first, end = measure_map[measure].second;
-            i < end; ++i )
-        {
-            assert(i < measures.size());
-            const MonIndex& ind = measures[i];
-            assert(ind.measure == measure);
-            if( ind.deployMask != Deploy::NA ) continue;        // skip measures tracking deployments
-            
-            size_t index = survey * surveySize +
-                    ind.index(ageIndex, cohortSet, species, genotype, drug);
-            assert( index < reports.size() );
-            reports[index] += val;
-        }
+        add( val, measure, Deploy::NA, survey, ageIndex, cohortSet, species,
+             genotype, drug );
     }
     
     // Take a deployment report and potentially store it in one or more places
@@ -313,21 +585,35 @@ public:
         if( survey == NOT_USED ) return; // pre-main-sim & unit tests we ignore all reports
         assert( method == Deploy::TIMED ||
             method == Deploy::CTS || method == Deploy::TREAT );
-        assert(measure < measure_map.size());
-        for( size_t i = measure_map[measure].first, end = measure_map[measure].second;
-            i < end; ++i )
-        {
-            assert(i < measures.size());
-            const MonIndex& ind = measures[i];
-            assert(ind.measure == measure);
-            // skip measures not tracking deployments or not tracking this type of deployment
-            if( (ind.deployMask & method) == Deploy::NA ) continue;
-            assert( ind.nSpecies == 1 && ind.nGenotypes == 1 );     // never used for deployments
-            
-            size_t index = survey * surveySize +
-                    ind.index(ageIndex, cohortSet, 0, 0, 0);
-            assert( index < reports.size() );
-            reports[index] += val;
+        add( val, measure, method, survey, ageIndex, cohortSet, 0, 0, 0 );
+    }
+    
+    // Store reports made during a partitioned update, in partition order.
+    void mergePending(){
+        assert( !util::parallel::active() );
+        for( size_t p = 0; p < buffers.size(); ++p ){
+            foreach( Slice& slice, buffers[p] ){
+                if( slice.survey == NOT_USED ) continue;
+                T *values = &reports[surveyOffset(slice.survey)];
+                foreach( size_t index, slice.touched ){
+                    values[index] += slice.values[index];
+                    slice.values[index] = 0;
+                }
+                slice.touched.clear();
+                slice.survey = NOT_USED;
+            }
+        }
+        for( size_t p = 0; p < pending.size(); ++p ){
+            foreach( const Pending& r, pending[p] ){
+                if( r.method == Deploy::NA ){
+                    report( r.val, r.measure, r.survey, r.ageIndex, r.cohortSet,
+                            r.species, r.genotype, r.drug );
+                }else{
+                    deploy( r.val, r.measure, r.survey, r.ageIndex, r.cohortSet,
+                            r.method );
+                }
+            }
+            pending[p].clear();
         }
     }
     
@@ -347,7 +633,7 @@ public:
             assert(ind.measure == measure);
             if( ind.deployMask != method ) continue;    // incompatible deployment mode: skip
             
-            const size_t off = survey * surveySize + ind.offset;
+            const size_t off = surveyOffset(survey) + ind.offset;
             T sum = 0;
             size_t end2 = off + ind.size();
             assert(end2 <= reports.size());
@@ -374,32 +660,49 @@ public:
         {
             assert(i < measures.size());
             if( measures[i].outMeasure == om.outId ){
-                measures[i].write( stream, survey + 1, om, reports, survey * surveySize );
+                if( impl::binaryOutput ){
+                    measures[i].writeBinary( stream, survey + 1, om, reports, surveyOffset(survey) );
+                }else{
+                    measures[i].write( stream, survey + 1, om, reports, surveyOffset(survey) );
+                }
                 return;
             }
         }
         assert(false && "measure not found in records");
     }
     
+    // Discard data for surveys before `survey` (which must have been written)
+    void release( size_t survey ){
+        if( survey <= firstSurvey ) return;
+        const size_t n = std::min( (survey - firstSurvey) * surveySize, reports.size() );
+        reports.erase( reports.begin(), reports.begin() + n );
+        firstSurvey = survey;
+    }
+    
     // Checkpointing
     void checkpoint( ostream& stream ){
+        firstSurvey & stream;
         reports.size() & stream;
         foreach (T& y, reports) {
             y & stream;
         }
-        // reports is the only field which changes after initialisation
+        // reports and firstSurvey are the only fields which change after initialisation
     }
     void checkpoint( istream& stream ){
+        firstSurvey & stream;
         size_t l;
         l & stream;
-        if( l != size() ){
+        const bool valid = impl::streamOutput ?
+            (surveySize == 0 ? l == 0 : l % surveySize == 0) :
+            (firstSurvey == 0 && l == size());
+        if( !valid ){
             throw util::checkpoint_error( "mon::reports: invalid list size" );
         }
         reports.resize (l);
         foreach (T& y, reports) {
             y & stream;
         }
-        // reports is the only field which changes after initialisation
+        // reports and firstSurvey are the only fields which change after initialisation
     }
 };
 
@@ -409,6 +712,9 @@ vector<OutMeasure> reportedMeasures;
 Store<int> storeI;
 Store<double> storeF;
 int reportIMR = -1; // special output for fitting
+// Names of things, used in the header of binary output:
+map<int,string> outMeasureNames;        // key is output number
+vector<string> speciesNames, drugNames;
 
 struct MeasureByOutId{
     bool operator() (const OutMeasure& i,const OutMeasure& j) {
@@ -505,16 +811,27 @@ void internal::initReporting( const scnXml::Scenario& scenario ){
                 "number %1% used more than once") %om.outId).str() );
         }
         outIds.insert( om.outId );
+        outMeasureNames[om.outId] = optElt.getName();
         
         reportedMeasures.push_back( om );
     }
     
     std::sort( reportedMeasures.begin(), reportedMeasures.end(), measureByOutId );
     
-    size_t nSpecies = scenario.getEntomology().getVector().present() ?
-        scenario.getEntomology().getVector().get().getAnopheles().size() : 1;
-    size_t nDrugs = scenario.getPharmacology().present() ?
-        scenario.getPharmacology().get().getDrugs().getDrug().size() : 1;
+    if( scenario.getEntomology().getVector().present() ){
+        foreach( const scnXml::AnophelesParams& anoph,
+                scenario.getEntomology().getVector().get().getAnopheles() ){
+            speciesNames.push_back( anoph.getMosquito() );
+        }
+    }
+    if( scenario.getPharmacology().present() ){
+        foreach( const scnXml::PKPDDrug& drug,
+                scenario.getPharmacology().get().getDrugs().getDrug() ){
+            drugNames.push_back( drug.getAbbrev() );
+        }
+    }
+    size_t nSpecies = std::max<size_t>( speciesNames.size(), 1 );
+    size_t nDrugs = std::max<size_t>( drugNames.size(), 1 );
     
     storeI.init( reportedMeasures, nSpecies, nDrugs );
     storeF.init( reportedMeasures, nSpecies, nDrugs );
@@ -562,26 +879,85 @@ bool checkCondition( size_t conditionKey ){
     return impl::conditions[conditionKey].value;
 }
 
+void internal::writeHeader( ostream& stream ){
+    if( !impl::binaryOutput ) return;   // text output has no header
+    
+    // The header describes the blocks which follow: one line per item, with
+    // tab-separated fields.
+    ostringstream header;
+    foreach( const OutMeasure& om, reportedMeasures ){
+        header << "measure\t" << om.outId << '\t' << outMeasureNames[om.outId]
+            << '\t' << (om.isDouble ? "double" : "int") << lineEnd;
+    }
+    // The last age group is not reported; bounds are in days
+    for( size_t i = 0; i + 1 < AgeGroup::numGroups(); ++i ){
+        header << "ageGroup\t" << (i + 1) << '\t'
+            << AgeGroup::getUpperBound( i ).inDays() << lineEnd;
+    }
+    for( uint32_t cohortSet = 0; cohortSet < impl::nCohorts; ++cohortSet ){
+        header << "cohort\t" << cohortSetOutputId( cohortSet ) << lineEnd;
+    }
+    for( size_t i = 0; i < speciesNames.size(); ++i ){
+        header << "species\t" << (i + 1) << '\t' << speciesNames[i] << lineEnd;
+    }
+    header << "genotypes\t" << WithinHost::Genotypes::N() << lineEnd;
+    for( size_t i = 0; i < drugNames.size(); ++i ){
+        header << "drug\t" << (i + 1) << '\t' << drugNames[i] << lineEnd;
+    }
+    const string text = header.str();
+    
+    stream.write( "OMCOLBIN", 8 );
+    writeBinary<uint32_t>( stream, 1 );         // format version
+    writeBinary<uint32_t>( stream, 0x01020304 );        // byte order mark
+    writeBinary<uint32_t>( stream, text.size() );
+    stream.write( text.data(), text.size() );
+}
 void internal::write( ostream& stream ){
+    writeHeader( stream );
     for( size_t survey = 0; survey < impl::nSurveys; ++survey ){
-        foreach( const OutMeasure& om, reportedMeasures ){
-            if( om.m >= M_NUM ){
-                // "Special" measures are not reported this way. The only such measure is IMR.
-                assert( om.m == M_ALL_CAUSE_IMR && reportIMR >= 0 );
-                continue;
-            } else if( om.isDouble ) {
-                storeF.write( stream, survey, om );
-            } else {
-                storeI.write( stream, survey, om );
-            }
+        writeSurvey( stream, survey );
+    }
+    writeIMR( stream );
+}
+void internal::writeSurvey( ostream& stream, size_t survey ){
+    foreach( const OutMeasure& om, reportedMeasures ){
+        if( om.m >= M_NUM ){
+            // "Special" measures are not reported this way. The only such measure is IMR.
+            assert( om.m == M_ALL_CAUSE_IMR && reportIMR >= 0 );
+            continue;
+        } else if( om.isDouble ) {
+            storeF.write( stream, survey, om );
+        } else {
+            storeI.write( stream, survey, om );
         }
     }
+}
+void internal::releaseSurveys( size_t survey ){
+    storeI.release( survey );
+    storeF.release( survey );
+}
+void internal::writeIMR( ostream& stream ){
     if( reportIMR >= 0 ){
         // Infant mortality rate is a single number, therefore treated specially.
         // It is calculated across the entire intervention period and used in
         // model fitting.
-        stream << 1 << "\t" << 1 << "\t" << reportIMR
-            << "\t" << Clinical::infantAllCauseMort() << lineEnd;
+        if( impl::binaryOutput ){
+            // a block of one row, survey 1, age group 1 (as in the text
+            // output below), no other categories
+            writeBinary<int32_t>( stream, reportIMR );
+            writeBinary<uint32_t>( stream, 1 );
+            writeBinary<uint32_t>( stream, 1 );
+            writeBinary<uint8_t>( stream, 1 );
+            writeBinary<uint16_t>( stream, 1 );
+            writeBinary<uint32_t>( stream, 0 );
+            writeBinary<uint16_t>( stream, 0 );
+            writeBinary<uint16_t>( stream, 0 );
+            writeBinary<uint16_t>( stream, 0 );
+            writeBinary<double>( stream, Clinical::infantAllCauseMort() );
+        }else{
+            stream << 1 << "\t" << 1 << "\t" << reportIMR
+                << "\t" << Clinical::infantAllCauseMort() << lineEnd;
+        }
     }
 }
 
@@ -667,6 +1043,11 @@ void reportStatMSGF( Measure measure, size_t species, size_t genotype, double va
     storeF.report( val, measure, survey, 0, 0, species, genotype, 0 );
 }
 
+void mergePartitionReports(){
+    storeI.mergePending();
+    storeF.mergePending();
+}
+
 bool isUsedM( Measure measure ){
     return storeI.isUsed(measure) || storeF.isUsed(measure);
 }
@@ -678,6 +1059,7 @@ void checkpoint( ostream& stream ){
     impl::survNumStat & stream;
     impl::nextSurveyTime & stream;
     
+    internal::checkpointOutput(stream);
     storeI.checkpoint(stream);
     storeF.checkpoint(stream);
 }
@@ -688,6 +1070,7 @@ void checkpoint( istream& stream ){
     impl::survNumStat & stream;
     impl::nextSurveyTime & stream;
     
+    internal::checkpointOutput(stream);
     storeI.checkpoint(stream);
     storeF.checkpoint(stream);
 }
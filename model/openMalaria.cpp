@@ -24,65 +24,49 @@
 #include "Global.h"
 #include "Simulator.h"
 #include "util/CommandLine.h"
+#include "util/parallel.h"
 #include "util/errors.h"
 
 #include <cstdio>
 #include <cerrno>
 
+#if defined(WITHOUT_BOINC) && !defined(_WIN32)
+#define OM_BATCH
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <map>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 using namespace OM;
 
-/** main() — initializes and shuts down BOINC, loads scenario XML and
- * runs simulation. */
-int main(int argc, char* argv[]) {
-    int exitStatus = EXIT_SUCCESS;
-    string scenarioFile;
-    
+namespace {
+
+/** Called from a catch block: print the current exception and return the
+ * exit status to use. */
+int reportException( const string& scenarioFile ){
     try {
-        util::set_gsl_handler();        // init
-        
-        scenarioFile = util::CommandLine::parse (argc, argv);   // parse arguments
-        
-        util::BoincWrapper::init();     // BOINC init
-        
-        // Load the scenario document:
-        scenarioFile = util::CommandLine::lookupResource (scenarioFile);
-        util::DocumentLoader documentLoader;
-        util::Checksum cksum = documentLoader.loadDocument(scenarioFile);
-        
-        // Set up the simulator
-        Simulator simulator( cksum, documentLoader.document() );
-        
-        // Save changes to the document if any occurred.
-        documentLoader.saveDocument();
-        
-        if ( !util::CommandLine::option(util::CommandLine::SKIP_SIMULATION) )
-            simulator.start(documentLoader.document().getMonitoring());
-        
-        // Write scenario checksum, only if simulation completed.
-        // Writing it earlier breaks checkpointing.
-        cksum.writeToFile (util::BoincWrapper::resolveFile ("scenario.sum"));
-        
-        // We call boinc_finish before cleanup since it should help ensure
-        // app isn't killed between writing output.txt and calling boinc_finish,
-        // and may speed up exit.
-        util::BoincWrapper::finish(exitStatus);	// Never returns
-        
-        // simulation's destructor runs
+        throw;
     } catch (const OM::util::cmd_exception& e) {
         if( e.getCode() == 0 ){
             // this is not an error, but exiting due to command line
             cerr << e.what() << "; exiting..." << endl;
+            return EXIT_SUCCESS;
         }else{
             cerr << "Command-line error: "<<e.what();
-            exitStatus = e.getCode();
+            return e.getCode();
         }
     } catch (const ::xsd::cxx::tree::exception<char>& e) {
         cerr << "XSD error: " << e.what() << '\n' << e << endl;
-        exitStatus = OM::util::Error::XSD;
+        return OM::util::Error::XSD;
     } catch (const OM::util::checkpoint_error& e) {
         cerr << "Checkpoint error: " << e.what() << endl;
         cerr << e << flush;
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const OM::util::traced_exception& e) {
         cerr << "Code error: " << e.what() << endl;
         cerr << e << flush;
@@ -91,22 +75,25 @@ int main(int argc, char* argv[]) {
         // it anyway!
         cerr << "This is likely an error in the C++ code. Please report!" << endl;
 #endif
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const OM::util::xml_scenario_error& e) {
         cerr << "Error: " << e.what() << endl;
         cerr << "In: " << scenarioFile << endl;
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const OM::util::base_exception& e) {
         cerr << "Error: " << e.message() << endl;
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
-        exitStatus = EXIT_FAILURE;
+        return EXIT_FAILURE;
     } catch (...) {
         cerr << "Unknown error" << endl;
-        exitStatus = EXIT_FAILURE;
+        return EXIT_FAILURE;
     }
-    
+}
+
+/** Finish after an error (or exiting due to the command line). */
+int finishWith( int exitStatus ){
     // If we get to here, we already know an error occurred.
     if( errno != 0 )
         std::perror( "OpenMalaria" );
@@ -118,3 +105,332 @@ int main(int argc, char* argv[]) {
     // here. In this case we shouldn't call boinc_finish (it breaks tests).
     return exitStatus;
 }
+
+/** Load a scenario and run the simulation.
+ * 
+ * On success this calls BoincWrapper::finish and doesn't return. Otherwise
+ * returns the exit status.
+ * 
+ * @param scenarioFile Scenario, looked up as a resource
+ * @param sumFile File to write the scenario checksum to */
+int runScenario( string scenarioFile, const string& sumFile ){
+    int exitStatus = EXIT_SUCCESS;
+    try {
+        util::BoincWrapper::init();     // BOINC init
+        
+        // Load the scenario document:
+        scenarioFile = util::CommandLine::lookupResource (scenarioFile);
+        util::DocumentLoader documentLoader;
+        util::Checksum cksum = documentLoader.loadDocument(scenarioFile);
+        
+        // Set up the simulator
+        Simulator simulator( cksum, documentLoader.document(),
+                documentLoader.getWarmupKey() );
+        
+        // Save changes to the document if any occurred.
+        documentLoader.saveDocument();
+        
+        if ( !util::CommandLine::option(util::CommandLine::SKIP_SIMULATION) )
+            simulator.start(documentLoader.document().getMonitoring());
+        
+        // Write scenario checksum, only if simulation completed.
+        // Writing it earlier breaks checkpointing.
+        cksum.writeToFile (util::BoincWrapper::resolveFile (sumFile));
+        
+        // We call boinc_finish before cleanup since it should help ensure
+        // app isn't killed between writing output.txt and calling boinc_finish,
+        // and may speed up exit.
+        util::BoincWrapper::finish(exitStatus);	// Never returns
+        
+        // simulation's destructor runs
+    } catch (...) {
+        exitStatus = reportException( scenarioFile );
+    }
+    return finishWith( exitStatus );
+}
+
+#ifdef OM_BATCH
+/// One line of a batch file
+struct BatchJob {
+    string scenario, output, ctsout, sum;
+    // Index of the group of jobs sharing this job's warm-up, or -1
+    int group;
+};
+
+/** Read a batch file (see --batch). Throws cmd_exception if it is malformed
+ * or two jobs would write the same file. */
+vector<BatchJob> readBatchFile( const string& fileName ){
+    ifstream file( fileName.c_str() );
+    if( !file.good() )
+        throw util::cmd_exception( "--batch: unable to open " + fileName );
+    
+    vector<BatchJob> jobs;
+    set<string> outputs;
+    string line;
+    for( int lineNo = 1; getline( file, line ); ++lineNo ){
+        istringstream fields( line );
+        vector<string> words;
+        string word;
+        while( fields >> word ) words.push_back( word );
+        if( words.empty() || words[0][0] == '#' ) continue;
+        
+        BatchJob job;
+        job.group = -1;
+        if( words.size() == 1 ){
+            // same files as --name NAME
+            job.scenario = "scenario" + words[0] + ".xml";
+            job.output = "output" + words[0] + ".txt";
+            job.ctsout = "ctsout" + words[0] + ".txt";
+        }else if( words.size() == 3 ){
+            job.scenario = words[0];
+            job.output = words[1];
+            job.ctsout = words[2];
+        }else{
+            ostringstream msg;
+            msg << fileName << ":" << lineNo
+                << ": expected NAME or three file names (scenario, output, ctsout)";
+            throw util::cmd_exception( msg.str() );
+        }
+        
+        // scenario.sum becomes e.g. scenarioNAME.sum (in the working directory)
+        string base = job.scenario.substr( job.scenario.find_last_of( "/\\" ) + 1 );
+        if( base.size() > 4 && base.compare( base.size() - 4, 4, ".xml" ) == 0 )
+            base.resize( base.size() - 4 );
+        job.sum = base + ".sum";
+        
+        const string *files[] = { &job.output, &job.ctsout, &job.sum };
+        for( size_t i = 0; i < 3; ++i ){
+            if( !outputs.insert( *files[i] ).second ){
+                ostringstream msg;
+                msg << fileName << ":" << lineNo << ": " << *files[i]
+                    << " is written by an earlier job";
+                throw util::cmd_exception( msg.str() );
+            }
+        }
+        jobs.push_back( job );
+    }
+    if( jobs.empty() )
+        throw util::cmd_exception( "--batch: no scenarios listed in " + fileName );
+    return jobs;
+}
+
+/** Group jobs with the same warm-up (DocumentLoader::getWarmupKey(), which
+ * requires the warm-up snapshot directory to be set). Sets BatchJob::group
+ * for jobs in groups of two or more and returns the key of each group.
+ * 
+ * Jobs whose scenario can't be loaded are left alone; they report the error
+ * when run. So are jobs with continuous output during initialisation, unless
+ * snapshots were requested explicitly, since runs starting from a snapshot
+ * don't produce that output. */
+vector<string> groupJobs( vector<BatchJob>& jobs, bool explicitSnapshots ){
+    vector<string> keys( jobs.size() );
+    map<string, size_t> count;
+    for( size_t i = 0; i < jobs.size(); ++i ){
+        try {
+            util::DocumentLoader loader;
+            loader.loadDocument( util::CommandLine::lookupResource( jobs[i].scenario ) );
+            const scnXml::Monitoring::ContinuousOptional& cts =
+                loader.document().getMonitoring().getContinuous();
+            if( !explicitSnapshots && cts.present() &&
+                cts.get().getDuringInit().present() && cts.get().getDuringInit().get() )
+                continue;
+            keys[i] = loader.getWarmupKey();
+            ++count[keys[i]];
+        } catch (...) {
+            // the job reports this itself
+        }
+    }
+    
+    vector<string> groups;
+    map<string, int> groupOf;
+    for( size_t i = 0; i < jobs.size(); ++i ){
+        if( keys[i].empty() || count[keys[i]] < 2 ) continue;
+        map<string, int>::iterator it = groupOf.find( keys[i] );
+        if( it == groupOf.end() ){
+            it = groupOf.insert( make_pair( keys[i], static_cast<int>(groups.size()) ) ).first;
+            groups.push_back( keys[i] );
+        }
+        jobs[i].group = it->second;
+    }
+    return groups;
+}
+
+/// A process run by runBatch(): a job, or the warm-up shared by a group
+struct BatchTask {
+    size_t job;         // index in jobs (for a warm-up, the group's first job)
+    bool warmup;
+};
+
+/** Run all scenarios in a batch file, up to --jobs at once.
+ * 
+ * Each scenario runs in a child process forked from this one. Model state is
+ * held in static variables, so scenarios can't share a process.
+ * 
+ * Instead, jobs with the same warm-up (scenarios differing only in
+ * monitoring and intervention deployments, see --warmup-snapshot) share it:
+ * one process runs the warm-up of the group and saves a warm-up snapshot,
+ * then each job of the group starts from the snapshot. Snapshots are stored
+ * in the --warmup-snapshot directory if given, otherwise in a temporary
+ * directory removed at the end.
+ * 
+ * Returns EXIT_SUCCESS if all jobs succeeded, otherwise the exit status of
+ * the first job to fail. */
+int runBatch( const string& fileName ){
+    vector<BatchJob> jobs = readBatchFile( fileName );
+    
+    size_t maxJobs = util::CommandLine::getBatchJobs();
+    if( maxJobs == 0 ){
+        long nProcs = sysconf( _SC_NPROCESSORS_ONLN );
+        maxJobs = nProcs > 0 ? nProcs / util::parallel::numThreads() : 1;
+        if( maxJobs == 0 ) maxJobs = 1;
+    }
+    
+    const string userSnapshotDir = util::CommandLine::getWarmupSnapshotDir();
+    string snapshotDir = userSnapshotDir;
+    if( snapshotDir == "" ){
+        char name[] = "batch-warmup-XXXXXX";
+        if( mkdtemp( name ) == 0 )
+            throw TRACED_EXCEPTION( string("--batch: unable to create directory: ")
+                + strerror( errno ), util::Error::Default );
+        snapshotDir = name;
+    }
+    util::CommandLine::setWarmupSnapshot( snapshotDir, false );
+    const vector<string> groups = groupJobs( jobs, userSnapshotDir != "" );
+    
+    // Warm-ups first, then jobs in order. A job in a group may start once
+    // the group's warm-up has finished.
+    vector<BatchTask> tasks;
+    vector<bool> warmupDone( groups.size(), false );
+    for( size_t i = 0, g = 0; i < jobs.size() && g < groups.size(); ++i ){
+        if( jobs[i].group == static_cast<int>(g) ){
+            BatchTask task = { i, true };
+            tasks.push_back( task );
+            ++g;
+        }
+    }
+    for( size_t i = 0; i < jobs.size(); ++i ){
+        BatchTask task = { i, false };
+        tasks.push_back( task );
+    }
+    
+    int exitStatus = EXIT_SUCCESS;
+    size_t firstWaiting = 0, nFailed = 0;
+    vector<bool> started( tasks.size(), false );
+    map<pid_t, size_t> running;     // child process → task index
+    while( firstWaiting < tasks.size() || !running.empty() ){
+        // find the next task which may start
+        size_t next = tasks.size();
+        if( running.size() < maxJobs ){
+            for( size_t t = firstWaiting; t < tasks.size(); ++t ){
+                if( started[t] ) continue;
+                const int group = jobs[tasks[t].job].group;
+                if( tasks[t].warmup || group < 0 || warmupDone[group] ){
+                    next = t;
+                    break;
+                }
+            }
+        }
+        if( next < tasks.size() ){
+            // flush so children don't repeat buffered output
+            cout << flush;
+            cerr << flush;
+            pid_t pid = fork();
+            if( pid == 0 ){
+                const BatchTask& task = tasks[next];
+                const BatchJob& job = jobs[task.job];
+                if( task.warmup )
+                    util::CommandLine::setWarmupSnapshot( snapshotDir, true );
+                else if( job.group < 0 )
+                    util::CommandLine::setWarmupSnapshot( userSnapshotDir, false );
+                util::CommandLine::setOutputNames( job.output, job.ctsout );
+                exit( runScenario( job.scenario, job.sum ) );
+            }
+            if( pid > 0 ){
+                running[pid] = next;
+                started[next] = true;
+                while( firstWaiting < tasks.size() && started[firstWaiting] )
+                    ++firstWaiting;
+                continue;
+            }
+            if( running.empty() )
+                throw TRACED_EXCEPTION( string("--batch: unable to start process: ")
+                    + strerror( errno ), util::Error::Default );
+            // otherwise wait for a job to finish and try again
+            errno = 0;
+        }
+        
+        int status;
+        pid_t pid = waitpid( -1, &status, 0 );
+        if( pid < 0 ){
+            if( errno == EINTR ){ errno = 0; continue; }
+            throw TRACED_EXCEPTION( string("--batch: waitpid failed: ")
+                + strerror( errno ), util::Error::Default );
+        }
+        map<pid_t, size_t>::iterator it = running.find( pid );
+        if( it == running.end() ) continue;
+        const BatchTask& task = tasks[it->second];
+        const BatchJob& job = jobs[task.job];
+        running.erase( it );
+        
+        int jobStatus = EXIT_SUCCESS;
+        if( WIFEXITED( status ) ){
+            jobStatus = WEXITSTATUS( status );
+            if( jobStatus != EXIT_SUCCESS )
+                cerr << "Batch: " << job.scenario << (task.warmup ? " warm-up" : "")
+                    << " failed with exit status " << jobStatus << endl;
+        }else if( WIFSIGNALED( status ) ){
+            jobStatus = EXIT_FAILURE;
+            cerr << "Batch: " << job.scenario << (task.warmup ? " warm-up" : "")
+                << " was killed by signal " << WTERMSIG( status ) << endl;
+        }
+        if( task.warmup ){
+            // Jobs may start now. If no snapshot was saved, each runs the
+            // warm-up itself (and reports any error).
+            warmupDone[job.group] = true;
+        }else if( jobStatus != EXIT_SUCCESS ){
+            ++nFailed;
+            if( exitStatus == EXIT_SUCCESS ) exitStatus = jobStatus;
+        }
+    }
+    
+    if( userSnapshotDir == "" ){
+        for( size_t g = 0; g < groups.size(); ++g )
+            remove( Simulator::warmupSnapshotFile( groups[g] ).c_str() );
+        if( rmdir( snapshotDir.c_str() ) != 0 )
+            cerr << "Batch: unable to remove " << snapshotDir << ": "
+                << strerror( errno ) << endl;
+        errno = 0;
+    }
+    
+    if( nFailed > 0 )
+        cerr << "Batch: " << nFailed << " of " << jobs.size() << " scenarios failed" << endl;
+    return exitStatus;
+}
+#else
+int runBatch( const string& ){
+    // CommandLine::parse already rejects --batch in this case
+    throw util::cmd_exception( "--batch: not supported by this build" );
+}
+#endif
+
+}
+
+/** main() — initializes and shuts down BOINC, loads scenario XML and
+ * runs simulation (or a batch of them). */
+int main(int argc, char* argv[]) {
+    int exitStatus;
+    
+    try {
+        util::set_gsl_handler();        // init
+        
+        string scenarioFile = util::CommandLine::parse (argc, argv);   // parse arguments
+        
+        if( util::CommandLine::getBatchFile() == "" )
+            return runScenario( scenarioFile, "scenario.sum" );
+        // Errors in jobs are reported by the job's own process
+        return runBatch( util::CommandLine::getBatchFile() );
+    } catch (...) {
+        exitStatus = reportException( "" );
+    }
+    return finishWith( exitStatus );
+}
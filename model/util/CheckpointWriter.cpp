@@ -0,0 +1,212 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "util/CheckpointWriter.h"
+#include "util/errors.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#if defined(WITHOUT_BOINC) && !defined(_WIN32)
+#define OM_ASYNC_CHECKPOINT
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <zlib.h>
+#endif
+
+namespace OM { namespace util {
+
+#ifdef OM_ASYNC_CHECKPOINT
+
+struct CheckpointWriter::Job {
+    std::string data, fileName, seedFile, seedData, pointerFile, pointerText,
+        truncateFile;
+    bool compress;
+    pthread_t thread;
+    std::string error;  // empty unless the write failed
+};
+
+namespace {
+    std::string errnoMsg( const std::string& what, const std::string& file ){
+        return what + " \"" + file + "\": " + strerror( errno );
+    }
+
+    /// Write len bytes to file and fsync before returning.
+    void writeDurably( const std::string& file, const char *data, size_t len ){
+        int fd = open( file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+        if( fd < 0 ) throw checkpoint_error( errnoMsg( "unable to open", file ) );
+        while( len > 0 ){
+            ssize_t n = ::write( fd, data, len );
+            if( n < 0 ){
+                if( errno == EINTR ) continue;
+                std::string msg = errnoMsg( "error writing", file );
+                close( fd );
+                throw checkpoint_error( msg );
+            }
+            data += n;
+            len -= n;
+        }
+        if( fsync( fd ) != 0 ){
+            std::string msg = errnoMsg( "error syncing", file );
+            close( fd );
+            throw checkpoint_error( msg );
+        }
+        if( close( fd ) != 0 )
+            throw checkpoint_error( errnoMsg( "error closing", file ) );
+    }
+
+    /// Make a rename in the working directory durable
+    void syncDirectory(){
+        int fd = open( ".", O_RDONLY );
+        if( fd < 0 ) return;    // not all systems allow this; best effort
+        fsync( fd );
+        close( fd );
+    }
+
+    /// Compress data in gzip format (as written by ogzstream)
+    void gzipCompress( const std::string& data, std::string& out ){
+        z_stream zs;
+        memset( &zs, 0, sizeof(zs) );
+        // windowBits 15 + 16: gzip header and trailer
+        if( deflateInit2( &zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                Z_DEFAULT_STRATEGY ) != Z_OK )
+            throw checkpoint_error( "deflateInit2 failed" );
+        out.resize( deflateBound( &zs, data.size() ) + 32 );
+        zs.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( data.data() ) );
+        zs.avail_in = data.size();
+        zs.next_out = reinterpret_cast<Bytef*>( &out[0] );
+        zs.avail_out = out.size();
+        int ret = deflate( &zs, Z_FINISH );
+        deflateEnd( &zs );
+        if( ret != Z_STREAM_END )
+            throw checkpoint_error( "checkpoint compression failed" );
+        out.resize( zs.total_out );
+    }
+
+    void runJob( CheckpointWriter::Job& job ){
+        try{
+            if( !job.seedFile.empty() )
+                writeDurably( job.seedFile, job.seedData.data(), job.seedData.size() );
+            
+            if( job.compress ){
+                std::string compressed;
+                gzipCompress( job.data, compressed );
+                std::string().swap( job.data );    // free memory early
+                writeDurably( job.fileName, compressed.data(), compressed.size() );
+            }else{
+                writeDurably( job.fileName, job.data.data(), job.data.size() );
+                std::string().swap( job.data );
+            }
+
+            // Replace the pointer file atomically:
+            std::string tmp = job.pointerFile + ".tmp";
+            writeDurably( tmp, job.pointerText.data(), job.pointerText.size() );
+            if( rename( tmp.c_str(), job.pointerFile.c_str() ) != 0 )
+                throw checkpoint_error( errnoMsg( "unable to rename", tmp ) );
+            syncDirectory();
+
+            if( !job.truncateFile.empty() )
+                writeDurably( job.truncateFile, 0, 0 );
+        }catch( const std::exception& e ){
+            job.error = e.what();
+        }
+    }
+
+    extern "C" void* runThread( void* p ){
+        runJob( *static_cast<CheckpointWriter::Job*>( p ) );
+        return 0;
+    }
+}
+
+
+CheckpointWriter::CheckpointWriter() : job(0) {}
+
+CheckpointWriter::~CheckpointWriter(){
+    try{
+        finish();
+    }catch( const std::exception& e ){
+        std::cerr << "Error writing checkpoint: " << e.what() << std::endl;
+    }
+}
+
+bool CheckpointWriter::available(){
+    return true;
+}
+
+void CheckpointWriter::write( std::string& data, const std::string& fileName,
+        bool compress, const std::string& seedFile, const std::string& seedData,
+        const std::string& pointerFile, const std::string& pointerText,
+        const std::string& truncateFile )
+{
+    finish();
+    job = new Job;
+    job->data.swap( data );
+    job->fileName = fileName;
+    job->compress = compress;
+    job->seedFile = seedFile;
+    job->seedData = seedData;
+    job->pointerFile = pointerFile;
+    job->pointerText = pointerText;
+    job->truncateFile = truncateFile;
+    if( pthread_create( &job->thread, 0, &runThread, job ) != 0 ){
+        // Fall back to writing on this thread
+        runJob( *job );
+        std::string error = job->error;
+        delete job;
+        job = 0;
+        if( !error.empty() ) throw checkpoint_error( error );
+    }
+}
+
+void CheckpointWriter::finish(){
+    if( job == 0 ) return;
+    pthread_join( job->thread, 0 );
+    std::string error = job->error;
+    delete job;
+    job = 0;
+    if( !error.empty() ) throw checkpoint_error( error );
+}
+
+#else   // no background writes in this build
+
+struct CheckpointWriter::Job {};
+
+CheckpointWriter::CheckpointWriter() : job(0) {}
+CheckpointWriter::~CheckpointWriter(){}
+
+bool CheckpointWriter::available(){
+    return false;
+}
+
+void CheckpointWriter::write( std::string&, const std::string&, bool,
+        const std::string&, const std::string&, const std::string&,
+        const std::string&, const std::string& )
+{
+    throw TRACED_EXCEPTION_DEFAULT( "background checkpoint writes not available in this build" );
+}
+
+void CheckpointWriter::finish(){}
+
+#endif
+
+} }
@@ -0,0 +1,89 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_CheckpointWriter
+#define Hmod_util_CheckpointWriter
+
+#include <string>
+
+namespace OM { namespace util {
+
+/** Writes checkpoint files on a background thread (see
+ * --checkpoint-async).
+ *
+ * The simulator serialises its state into memory, then hands the buffer to
+ * write(), which returns immediately. Compression and disk I/O happen on a
+ * separate thread while the simulation continues. Steps are done in order,
+ * each only after the previous is durable (fsync):
+ *
+ * 1.  the random number generator's seed file, if any, is written,
+ * 2.  the checkpoint file is written,
+ * 3.  the pointer file (naming the latest checkpoint) is replaced,
+ * 4.  the previous checkpoint file is truncated.
+ *
+ * So if the program is killed part-way through, the pointer file still names
+ * a complete checkpoint with a matching seed file.
+ *
+ * Only one write is in progress at a time. */
+class CheckpointWriter {
+public:
+    CheckpointWriter();
+    /// Waits for any pending write; errors are printed but not thrown.
+    ~CheckpointWriter();
+
+    /** True if this build supports background writes (POSIX threads and no
+     * BOINC, which needs to know when a checkpoint is complete). */
+    static bool available();
+
+    /** Start writing a checkpoint, first waiting for any previous write.
+     *
+     * @param data Serialised checkpoint. Swapped out (left empty) to avoid a
+     *  copy.
+     * @param fileName Checkpoint file to write
+     * @param compress Compress with gzip
+     * @param seedFile If not empty, write seedData to this file first (see
+     *  random::checkpoint)
+     * @param seedData Content for seedFile
+     * @param pointerFile File to replace with pointerText once fileName is
+     *  complete
+     * @param pointerText Content for pointerFile
+     * @param truncateFile If not empty, truncate this file last */
+    void write( std::string& data, const std::string& fileName, bool compress,
+                const std::string& seedFile, const std::string& seedData,
+                const std::string& pointerFile, const std::string& pointerText,
+                const std::string& truncateFile );
+
+    /** Wait for the pending write, if any, to complete.
+     *
+     * Throws checkpoint_error if it failed. */
+    void finish();
+
+    struct Job;         // implementation detail
+
+private:
+    Job *job;   // pending write or null
+
+    // not copyable
+    CheckpointWriter( const CheckpointWriter& );
+    void operator=( const CheckpointWriter& );
+};
+
+} }
+#endif
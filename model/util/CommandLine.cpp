@@ -24,6 +24,9 @@
 #include "util/BoincWrapper.h"
 #include "util/StreamValidator.h"
 #include "util/DocumentLoader.h"
+#include "util/parallel.h"
+#include "util/CheckpointWriter.h"
+#include "util/timer.h"
 /* if you get compile errors like "version.h not found", run CMake first */
 #include "util/version.h"
 
@@ -39,6 +42,9 @@ namespace OM { namespace util {
     string CommandLine::resourcePath;
     string CommandLine::outputName;
     string CommandLine::ctsoutName;
+    string CommandLine::batchFile;
+    size_t CommandLine::batchJobs = 0;
+    string CommandLine::warmupSnapshotDir;
     set<SimTime> CommandLine::checkpoint_times;
     
     string parseNextArg (int argc, char* argv[], int& i) {
@@ -51,7 +57,8 @@ namespace OM { namespace util {
     string CommandLine::parse (int argc, char* argv[]) {
 	options[COMPRESS_CHECKPOINTS] = true;	// turn on by default
 	
-	bool cloHelp = false, cloVersion = false, cloError = false;
+	bool cloHelp = false, cloVersion = false, cloError = false, cloProfile = false;
+	int nThreads = 1;
 	string scenarioFile = "";
         outputName = "";
         ctsoutName = "";
@@ -141,6 +148,84 @@ namespace OM { namespace util {
 			break;
 		    }
 		    options[COMPRESS_CHECKPOINTS] = b;
+		} else if (clo == "batch") {
+		    if (batchFile != "")
+			throw cmd_exception ("--batch may only be given once");
+		    batchFile = parseNextArg (argc, argv, i);
+		} else if (clo == "jobs") {
+		    stringstream t;
+		    int n;
+		    t << parseNextArg (argc, argv, i);
+		    t >> n;
+		    if (t.fail() || n <= 0) {
+			cerr << "Expected: --jobs N  where N is a positive integer" << endl;
+			cloError = true;
+			break;
+		    }
+		    batchJobs = n;
+		} else if (clo == "warmup-snapshot") {
+		    if (warmupSnapshotDir != "")
+			throw cmd_exception ("--warmup-snapshot may only be given once");
+		    warmupSnapshotDir = parseNextArg (argc, argv, i);
+		} else if (clo == "threads") {
+		    stringstream t;
+		    t << parseNextArg (argc, argv, i);
+		    t >> nThreads;
+		    if (t.fail() || nThreads <= 0) {
+			cerr << "Expected: --threads N  where N is a positive integer" << endl;
+			cloError = true;
+			break;
+		    }
+		} else if (clo.compare (0,4,"rng=") == 0) {
+		    string gen = clo.substr (4);
+		    if (gen == "philox") {
+			options.set (RNG_PHILOX);
+		    } else if (gen == "mt19937") {
+			options.reset (RNG_PHILOX);
+		    } else {
+			cerr << "Expected: --rng=x  where x is mt19937 or philox" << endl;
+			cloError = true;
+			break;
+		    }
+		} else if (clo.compare (0,16,"deploy-sampling=") == 0) {
+		    string method = clo.substr (16);
+		    if (method == "geometric") {
+			options.set (GEOMETRIC_DEPLOYMENT);
+		    } else if (method == "bernoulli") {
+			options.reset (GEOMETRIC_DEPLOYMENT);
+		    } else {
+			cerr << "Expected: --deploy-sampling=x  where x is bernoulli or geometric" << endl;
+			cloError = true;
+			break;
+		    }
+		} else if (clo.compare (0,19,"empirical-sampling=") == 0) {
+		    string method = clo.substr (19);
+		    if (method == "truncated") {
+			options.set (EMPIRICAL_TRUNCATED_SAMPLING);
+		    } else if (method == "rejection") {
+			options.reset (EMPIRICAL_TRUNCATED_SAMPLING);
+		    } else {
+			cerr << "Expected: --empirical-sampling=x  where x is rejection or truncated" << endl;
+			cloError = true;
+			break;
+		    }
+		} else if (clo.compare (0,14,"output-format=") == 0) {
+		    string format = clo.substr (14);
+		    if (format == "binary") {
+			options.set (BINARY_OUTPUT);
+		    } else if (format == "text") {
+			options.reset (BINARY_OUTPUT);
+		    } else {
+			cerr << "Expected: --output-format=x  where x is text or binary" << endl;
+			cloError = true;
+			break;
+		    }
+		} else if (clo == "stream-output") {
+		    options.set (STREAM_OUTPUT);
+		} else if (clo == "profile") {
+		    cloProfile = true;
+		} else if (clo == "checkpoint-async") {
+		    options.set (ASYNC_CHECKPOINTS);
 		} else if (clo == "checkpoint-duplicates") {
 		    options.set (TEST_DUPLICATE_CHECKPOINTS);
                 } else if (clo == "debug-vector-fitting") {
@@ -231,6 +316,47 @@ namespace OM { namespace util {
 	    << " -n --name NAME		Equivalent to --scenario scenarioNAME.xml --output outputNAME.txt \\"<<endl
 	    << "			--ctsout ctsoutNAME.txt" <<endl
 	    << "    --validate-only	Initialise and validate scenario, but don't run simulation." << endl
+	    << "    --batch FILE	Run each scenario listed in FILE in a separate worker process." << endl
+	    << "			Each line is either NAME (as for --name) or three file names:" << endl
+	    << "			scenario, output and ctsout. Blank lines and lines starting" << endl
+	    << "			'#' are ignored. The scenario checksum of each job is written" << endl
+	    << "			to the scenario file name with .sum in place of .xml." << endl
+	    << "			Jobs with the same warm-up (see --warmup-snapshot) share it:" << endl
+	    << "			it is run once and saved, and the jobs start from it. The" << endl
+	    << "			snapshot is kept only if --warmup-snapshot is given." << endl
+	    << "    --jobs N		With --batch, run up to N scenarios at once (default: number" << endl
+	    << "			of processors divided by --threads)." << endl
+	    << "    --threads N		Update humans using N threads (default 1). Results are" << endl
+	    << "			reproducible for a given seed and N, but differ between" << endl
+	    << "			values of N. Requires a build with OM_OPENMP." << endl
+	    << "    --warmup-snapshot DIR" << endl
+	    << "			Save the simulation state at the end of the warm-up in DIR, and" << endl
+	    << "			start later runs from it when nothing affecting the warm-up" << endl
+	    << "			has changed. Snapshots are keyed by the scenario excluding" << endl
+	    << "			intervention deployments and monitoring (except the survey" << endl
+	    << "			diagnostic and continuous output during initialisation)." << endl
+	    << "    --rng=x		Random number generator: mt19937 (default) or philox. With" << endl
+	    << "			philox each human has its own random number streams, so" << endl
+	    << "			results do not depend on --threads or update order." << endl
+	    << "    --deploy-sampling=x" << endl
+	    << "			How timed mass deployments select recipients: bernoulli" << endl
+	    << "			(default) draws a random number for each eligible human;" << endl
+	    << "			geometric skips between recipients, drawing one number per" << endl
+	    << "			recipient. Both give the same coverage in expectation, but" << endl
+	    << "			results differ." << endl
+	    << "    --empirical-sampling=x" << endl
+	    << "			How the empirical within-host model samples log densities:" << endl
+	    << "			rejection (default) retries draws above the limit; truncated" << endl
+	    << "			samples the same distribution directly, at a fixed cost per" << endl
+	    << "			sample. Results differ." << endl
+	    << "    --output-format=x" << endl
+	    << "			Format of the survey output file: text (default) or binary," << endl
+	    << "			a columnar format which is faster to write and read (see" << endl
+	    << "			util/readBinaryOutput.py). The default output file name is" << endl
+	    << "			then output.bin." << endl
+	    << "    --stream-output	Write the results of each survey to the output file once" << endl
+	    << "			no more reports can arrive for it, instead of keeping all" << endl
+	    << "			results in memory until the end of the simulation." << endl
 	    << "    --deprecation-warnings" << endl
 	    << "			Warn about the use of features deemed error-prone and where" << endl
 	    << "			more flexible alternatives are available." << endl
@@ -257,6 +383,11 @@ namespace OM { namespace util {
 	    << "			identical to that read." <<endl
 	    << "    --compress-checkpoints=boolean" << endl
 	    << "			Set checkpoint compression on or off. Default is on." <<endl
+	    << "    --checkpoint-async" << endl
+	    << "			Compress and write checkpoints on a background thread while" <<endl
+	    << "			the simulation continues." <<endl
+	    << "    --profile		Print time spent in each part of the simulation at the end" << endl
+	    << "			of the run. Requires a build with OM_PROFILING." << endl
 	    << "    --debug-vector-fitting"<<endl
 	    << "			Show details of vector-parameter fitting. The fitting methods used" <<endl
 	    << "			aren't guaranteed to work. If they don't, this output should help"<<endl
@@ -281,6 +412,30 @@ namespace OM { namespace util {
 	    StreamValidator.loadStream( sVFile );
 #	endif
 	
+	parallel::init( nThreads );
+	if( cloProfile ){
+	    if( !profile::available() )
+		throw cmd_exception( "--profile: this build does not support profiling "
+		    "(compile with OM_PROFILING enabled)" );
+	    profile::enable();
+	}
+	if( options[ASYNC_CHECKPOINTS] && !CheckpointWriter::available() )
+	    throw cmd_exception( "--checkpoint-async: not supported by this build" );
+	
+	if (batchFile != "") {
+#	if defined(_WIN32) || !defined(WITHOUT_BOINC)
+	    throw cmd_exception( "--batch: not supported by this build" );
+#	endif
+	    if (scenarioFile != "" || outputName != "" || ctsoutName != "")
+		throw cmd_exception( "--batch may not be used along with --scenario, --output, --ctsout or --name" );
+	    // Jobs run in the same working directory, so would overwrite each
+	    // other's checkpoints.
+	    if (options[TEST_CHECKPOINTING] || options[TEST_DUPLICATE_CHECKPOINTS] || checkpoint_times.size())
+		throw cmd_exception( "--batch may not be used along with checkpointing options" );
+	} else if (batchJobs != 0) {
+	    throw cmd_exception( "--jobs requires --batch" );
+	}
+	
 	if (checkpoint_times.size())	// timed checkpointing overrides this
 	    options[TEST_CHECKPOINTING] = false;
         
@@ -288,7 +443,7 @@ namespace OM { namespace util {
             scenarioFile = "scenario.xml";
         }
 	if (outputName == ""){
-	    outputName = "output.txt";
+	    outputName = options[BINARY_OUTPUT] ? "output.bin" : "output.txt";
 	}
 	if (ctsoutName == ""){
             ctsoutName = "ctsout.txt";
@@ -301,6 +456,16 @@ namespace OM { namespace util {
 	return scenarioFile;
     }
     
+    void CommandLine::setOutputNames (const string& output, const string& ctsout) {
+	outputName = output;
+	ctsoutName = ctsout;
+    }
+    
+    void CommandLine::setWarmupSnapshot (const string& dir, bool warmupOnly) {
+	warmupSnapshotDir = dir;
+	options[WARMUP_ONLY] = warmupOnly;
+    }
+    
     string CommandLine::lookupResource (const string& path) {
 	string ret;
 	if (path.size() >= 1 && path[0] == '/') {
@@ -47,6 +47,9 @@ namespace OM { namespace util {
 	    /** Compress checkpoint files with gzip before writing.
 	     * Even with binary checkpoints, this has a big effect. */
 	    COMPRESS_CHECKPOINTS,
+	    /** Write checkpoint files on a background thread (see
+	     * util::CheckpointWriter). */
+	    ASYNC_CHECKPOINTS,
 	    /** Do initialisation and error checks, but don't run simulation. */
 	    SKIP_SIMULATION,
 	    /** Print the annual EIR. */
@@ -66,6 +69,26 @@ namespace OM { namespace util {
             /** Print times of all surveys. */
             PRINT_SURVEY_TIMES,
             PRINT_GENOTYPES,
+            /** Use the counter-based Philox generator (per-human random
+             * number streams) instead of the Mersenne twister. */
+            RNG_PHILOX,
+            /** Select recipients of timed mass deployments by geometric
+             * skip-sampling instead of one Bernoulli trial per eligible
+             * human. */
+            GEOMETRIC_DEPLOYMENT,
+            /** Write survey results to the output file as surveys are
+             * completed instead of holding all in memory until the end. */
+            STREAM_OUTPUT,
+            /** Write survey output in a columnar binary format instead of
+             * text (see mon::internal::writeHeader). */
+            BINARY_OUTPUT,
+            /** Sample EmpiricalInfection log densities from a truncated
+             * normal distribution instead of by rejection sampling. */
+            EMPIRICAL_TRUNCATED_SAMPLING,
+            /** Stop at the end of the warm-up, once the warm-up snapshot is
+             * saved. Not a command-line option: set for --batch processes
+             * running a warm-up shared by several jobs. */
+            WARMUP_ONLY,
 	    NUM_OPTIONS
 	};
 	
@@ -99,6 +122,31 @@ namespace OM { namespace util {
             return ctsoutName;
         }
         
+        /** Set the names of the output and ctsout files (used by batch jobs,
+         * which each write their own). */
+        static void setOutputNames (const string& output, const string& ctsout);
+        
+        /** Get the name of the batch file (see --batch), or an empty string
+         * when running a single scenario. */
+        static inline string getBatchFile (){
+            return batchFile;
+        }
+        
+        /** Number of batch jobs to run at once (--jobs), or 0 if not given. */
+        static inline size_t getBatchJobs (){
+            return batchJobs;
+        }
+        
+        /** Get the directory in which warm-up snapshots are stored (see
+         * --warmup-snapshot), or an empty string if not used. */
+        static inline string getWarmupSnapshotDir (){
+            return warmupSnapshotDir;
+        }
+        
+        /** Set the warm-up snapshot directory and the WARMUP_ONLY option
+         * (used by batch jobs, which may share warm-ups). */
+        static void setWarmupSnapshot (const string& dir, bool warmupOnly);
+        
 	/** Looks through all command line options.
 	*
 	* @returns The name of the scenario XML file to use.
@@ -126,6 +174,13 @@ namespace OM { namespace util {
 	static string outputName;
         static string ctsoutName;
 	
+	// Batch mode (--batch, --jobs)
+	static string batchFile;
+	static size_t batchJobs;
+	
+	// Directory for warm-up snapshots (--warmup-snapshot)
+	static string warmupSnapshotDir;
+	
 	/** Set of simulation times at which a checkpoint should be written and
 	* program should exit (to allow resume). */
 	static set<SimTime> checkpoint_times;
@@ -20,12 +20,18 @@
 
 #include "util/DocumentLoader.h"
 #include "util/BoincWrapper.h"
+#include "util/CommandLine.h"
+#include "util/checkpoint.h"
+#include "util/parallel.h"
 #include "util/errors.h"
+/* if you get compile errors like "version.h not found", run CMake first */
+#include "util/version.h"
 
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <map>
+#include <cstring>
 #include <boost/format.hpp>
 
 namespace OM { namespace util {
@@ -47,6 +53,20 @@ Checksum DocumentLoader::loadDocument (std::string lXmlFile){
     }
     scenario = scnXml::parseScenario (fileStream);
     util::Checksum cksum = util::Checksum::generate (fileStream);
+    if( CommandLine::getWarmupSnapshotDir() != "" ){
+        fileStream.clear ();
+        fileStream.seekg (0);
+        ostringstream xml;
+        xml << fileStream.rdbuf();
+        // Snapshots also depend on the program and on options affecting random numbers
+        ostringstream key;
+        key << hashWarmupInputs( xml.str() ) << '\n'
+            << monitoringWarmupInputs( scenario->getMonitoring() ) << '\n' << semantic_version
+            << '\n' << checkpoint::FORMAT_VERSION
+            << '\n' << CommandLine::option( CommandLine::RNG_PHILOX )
+            << '\n' << parallel::numThreads();
+        warmupKey = hashWarmupInputs( key.str() );
+    }
     fileStream.close ();
     int scenarioVersion = scenario->getSchemaVersion();
     if (scenarioVersion < SCHEMA_VERSION) {
@@ -60,6 +80,87 @@ Checksum DocumentLoader::loadDocument (std::string lXmlFile){
     return cksum;
 }
 
+namespace {
+    /// True if an element with this name starts at xml[pos] (a '<')
+    bool isElement( const std::string& xml, size_t pos, const char *name ){
+        size_t len = strlen( name );
+        if( xml.compare( pos + 1, len, name ) != 0 ) return false;
+        size_t end = pos + 1 + len;
+        return end < xml.size() && strchr( " \t\r\n/>", xml[end] ) != 0;
+    }
+    
+    /// Return the position after the element starting at xml[pos] (a '<')
+    size_t skipElement( const std::string& xml, size_t pos, const char *name ){
+        size_t tagEnd = xml.find( '>', pos );
+        if( tagEnd == std::string::npos ) return xml.size();
+        if( xml[tagEnd - 1] == '/' ) return tagEnd + 1;     // <name ... />
+        size_t close = xml.find( std::string("</") + name, tagEnd );
+        if( close == std::string::npos ) return xml.size();
+        close = xml.find( '>', close );
+        return close == std::string::npos ? xml.size() : close + 1;
+    }
+}
+
+std::string DocumentLoader::monitoringWarmupInputs( const scnXml::Monitoring& monitoring ){
+    ostringstream inputs;
+    // The monitoring diagnostic is also used by the model during the warm-up
+    // (e.g. neonatal mortality), and may use random numbers.
+    const scnXml::Surveys& surveys = monitoring.getSurveys();
+    if( surveys.getDetectionLimit().present() )
+        inputs << "detectionLimit " << surveys.getDetectionLimit().get() << '\n';
+    if( surveys.getDiagnostic().present() )
+        inputs << "diagnostic " << surveys.getDiagnostic().get() << '\n';
+    // Continuous outputs reported during the warm-up may use random numbers
+    // (e.g. patent hosts with a stochastic diagnostic).
+    const scnXml::Monitoring::ContinuousOptional& ctsOpt = monitoring.getContinuous();
+    if( ctsOpt.present() && ctsOpt.get().getDuringInit().present()
+        && ctsOpt.get().getDuringInit().get() )
+    {
+        inputs << "continuous " << ctsOpt.get().getPeriod() << '\n';
+        const scnXml::OptionSet::OptionSequence& options = ctsOpt.get().getOption();
+        for( scnXml::OptionSet::OptionConstIterator it = options.begin(); it != options.end(); ++it ){
+            if( it->getValue() )
+                inputs << it->getName() << '\n';
+        }
+    }
+    return inputs.str();
+}
+
+std::string DocumentLoader::hashWarmupInputs( const std::string& xml ){
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    bool seenRoot = false;
+    for( size_t i = 0; i < xml.size(); ){
+        if( xml[i] == '<' ){
+            if( xml.compare( i, 4, "<!--" ) == 0 ){
+                size_t end = xml.find( "-->", i + 4 );
+                i = end == std::string::npos ? xml.size() : end + 3;
+                continue;
+            }
+            const char next = i + 1 < xml.size() ? xml[i+1] : '\0';
+            if( !seenRoot && next != '?' && next != '!' ){
+                // skip the root start tag (name, wuID and other attributes)
+                seenRoot = true;
+                size_t end = xml.find( '>', i );
+                i = end == std::string::npos ? xml.size() : end + 1;
+                continue;
+            }
+            if( isElement( xml, i, "monitoring" ) ){
+                i = skipElement( xml, i, "monitoring" );
+                continue;
+            }
+            if( isElement( xml, i, "deployment" ) ){
+                i = skipElement( xml, i, "deployment" );
+                continue;
+            }
+        }
+        hash ^= static_cast<unsigned char>( xml[i] );
+        hash *= 1099511628211ULL;
+        ++i;
+    }
+    return (boost::format("%016x") % hash).str();
+}
+
 void DocumentLoader::saveDocument()
 {
     if (documentChanged) {
@@ -48,6 +48,26 @@ public:
         * documentChanged is true. */
     void saveDocument();
     
+    /** Key identifying everything which affects the warm-up, used to name
+     * warm-up snapshots (see --warmup-snapshot). Empty unless that option was
+     * given. */
+    inline const std::string& getWarmupKey() const {
+        return warmupKey;
+    }
+    
+    /** Hash the scenario XML, excluding parts which don't affect the warm-up:
+     * comments, the attributes of the root element (name, wuID, etc.), the
+     * monitoring element and intervention deployment elements. The parts of
+     * monitoring which do matter are added by monitoringWarmupInputs().
+     * 
+     * Returns 16 hexadecimal digits. */
+    static std::string hashWarmupInputs( const std::string& xml );
+    
+    /** Describe the parts of the monitoring element which do affect the
+     * warm-up: the survey diagnostic (also used by the model) and, if output
+     * during initialisation, the continuous outputs. */
+    static std::string monitoringWarmupInputs( const scnXml::Monitoring& monitoring );
+    
     /** Get the base scenario element.
         *
         * Is an operator for brevity: InputData().getModel()...
@@ -76,6 +96,9 @@ private:
     /// Sometimes used to save changes to the xml.
     std::string xmlFileName;
     
+    /// See getWarmupKey()
+    std::string warmupKey;
+    
     /** @brief The xml data structure. */
     auto_ptr<scnXml::Scenario> scenario;
 };
@@ -0,0 +1,177 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_Quadrature
+#define Hmod_util_Quadrature
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace OM { namespace util {
+
+/** Fixed-order numerical integration, for use before falling back to
+ * gsl_integration_qag.
+ *
+ * gsl_integration_qag with rule 1 (GSL_INTEG_GAUSS15) starts by applying the
+ * 15-point Gauss-Kronrod rule to the whole interval; the difference from the
+ * embedded 7-point Gauss-Legendre rule gives an error estimate. For the
+ * smooth integrands of the drug models this is nearly always within
+ * tolerance and QAG returns immediately. Doing that first step here, with the
+ * integrand inlined instead of called through a void* callback, avoids the
+ * call overhead and the workspace bookkeeping. When the estimate is not
+ * within tolerance, callers use QAG as before.
+ *
+ * The arithmetic follows GSL's qk.c, so an accepted result is the value QAG
+ * would have returned. */
+namespace quadrature {
+    // Abscissae and weights of the 7-point Gauss / 15-point Kronrod rules
+    // (from QUADPACK, as in GSL's qk15.c)
+    const double xgk15[8] = {
+        0.991455371120812639206854697526329,
+        0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926,
+        0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013,
+        0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245,
+        0.000000000000000000000000000000000
+    };
+    const double wg7[4] = {
+        0.129484966168869693270611432679082,
+        0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975,
+        0.417959183673469387755102040816327
+    };
+    const double wgk15[8] = {
+        0.022935322010529224963732008058970,
+        0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518,
+        0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550,
+        0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649,
+        0.209482141084727828012999174891714
+    };
+
+    /// As GSL's rescale_error: turn |K15 - G7| into a less pessimistic estimate.
+    inline double rescaleError( double err, double resAbs, double resAsc ){
+        err = std::fabs( err );
+        if( resAsc != 0.0 && err != 0.0 ){
+            double scale = std::pow( 200.0 * err / resAsc, 1.5 );
+            err = scale < 1.0 ? resAsc * scale : resAsc;
+        }
+        const double eps = std::numeric_limits<double>::epsilon();
+        if( resAbs > std::numeric_limits<double>::min() / (50.0 * eps) ){
+            double minErr = 50.0 * eps * resAbs;
+            if( minErr > err ) err = minErr;
+        }
+        return err;
+    }
+
+    /** Apply the 15-point Gauss-Kronrod rule to f over [a,b].
+     *
+     * @param f Function object: double operator()(double) const
+     * @param result Integral estimate (Kronrod)
+     * @param absErr Error estimate
+     * @param resAbs Estimate of the integral of |f|
+     * @param resAsc Estimate of the integral of |f - mean(f)|
+     */
+    template<class F>
+    void gaussKronrod15( const F& f, double a, double b, double& result,
+            double& absErr, double& resAbs, double& resAsc )
+    {
+        const double center = 0.5 * (a + b);
+        const double halfLength = 0.5 * (b - a);
+        const double absHalfLength = std::fabs( halfLength );
+        const double fCenter = f( center );
+
+        double resGauss = fCenter * wg7[3];
+        double resKronrod = fCenter * wgk15[7];
+        resAbs = std::fabs( resKronrod );
+        double fv1[7], fv2[7];
+
+        // points shared by both rules
+        for( int j = 0; j < 3; ++j ){
+            const int jtw = j * 2 + 1;
+            const double abscissa = halfLength * xgk15[jtw];
+            const double fval1 = f( center - abscissa );
+            const double fval2 = f( center + abscissa );
+            const double fsum = fval1 + fval2;
+            fv1[jtw] = fval1;
+            fv2[jtw] = fval2;
+            resGauss += wg7[j] * fsum;
+            resKronrod += wgk15[jtw] * fsum;
+            resAbs += wgk15[jtw] * (std::fabs( fval1 ) + std::fabs( fval2 ));
+        }
+        // Kronrod-only points
+        for( int j = 0; j < 4; ++j ){
+            const int jtwm1 = j * 2;
+            const double abscissa = halfLength * xgk15[jtwm1];
+            const double fval1 = f( center - abscissa );
+            const double fval2 = f( center + abscissa );
+            fv1[jtwm1] = fval1;
+            fv2[jtwm1] = fval2;
+            resKronrod += wgk15[jtwm1] * (fval1 + fval2);
+            resAbs += wgk15[jtwm1] * (std::fabs( fval1 ) + std::fabs( fval2 ));
+        }
+
+        const double mean = resKronrod * 0.5;
+        resAsc = wgk15[7] * std::fabs( fCenter - mean );
+        for( int j = 0; j < 7; ++j ){
+            resAsc += wgk15[j] * (std::fabs( fv1[j] - mean ) + std::fabs( fv2[j] - mean ));
+        }
+
+        const double err = (resKronrod - resGauss) * halfLength;
+        result = resKronrod * halfLength;
+        resAbs *= absHalfLength;
+        resAsc *= absHalfLength;
+        absErr = rescaleError( err, resAbs, resAsc );
+    }
+
+    /** If false, fixedOrder() always defers to the adaptive method. Only
+     * intended for comparing the two (see QuadratureSuite). */
+    inline bool& fixedOrderEnabled(){
+        static bool enabled = true;
+        return enabled;
+    }
+
+    /** Integrate f over [a,b] with a single 15-point Gauss-Kronrod step,
+     * accepting the result under the same conditions as the first step of
+     * gsl_integration_qag.
+     *
+     * @returns True if result and absErr are set; false if the caller should
+     *  use an adaptive method instead (result and absErr are then
+     *  unspecified).
+     */
+    template<class F>
+    bool fixedOrder( const F& f, double a, double b, double epsAbs,
+            double epsRel, double& result, double& absErr )
+    {
+        if( !fixedOrderEnabled() ) return false;
+        double resAbs, resAsc;
+        gaussKronrod15( f, a, b, result, absErr, resAbs, resAsc );
+        const double tolerance = std::max( epsAbs, epsRel * std::fabs( result ) );
+        return (absErr <= tolerance && absErr != resAsc) || absErr == 0.0;
+    }
+}
+
+} }
+#endif
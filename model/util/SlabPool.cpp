@@ -0,0 +1,112 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "util/SlabPool.h"
+#include "util/parallel.h"
+#include <new>
+
+namespace OM { namespace util {
+
+// Slot alignment; enough for any type used here.
+const size_t ALIGN = 16;
+
+inline size_t roundUp( size_t n ){
+    return (n + ALIGN - 1) / ALIGN * ALIGN;
+}
+
+SlabPool::SlabPool( size_t size, size_t perSlab ) :
+    size( roundUp( size < sizeof(void*) ? sizeof(void*) : size ) ),
+    perSlab( perSlab ),
+    nextInSlab( perSlab ),      // no slab yet
+    freeList( 0 )
+{}
+
+SlabPool::~SlabPool(){
+    for( size_t i = 0; i < slabs.size(); ++i )
+        ::operator delete( slabs[i] );
+}
+
+void* SlabPool::allocate(){
+    if( freeList != 0 ){
+        void* p = freeList;
+        freeList = *static_cast<void**>( p );
+        return p;
+    }
+    if( nextInSlab == perSlab ){
+        slabs.push_back( static_cast<char*>( ::operator new( size * perSlab ) ) );
+        nextInSlab = 0;
+    }
+    void* p = slabs.back() + size * nextInSlab;
+    ++nextInSlab;
+    return p;
+}
+
+void SlabPool::deallocate( void* p ){
+    *static_cast<void**>( p ) = freeList;
+    freeList = p;
+}
+
+
+namespace slab {
+    // Objects larger than this are not pooled (sub-models are much smaller)
+    const size_t MAX_POOLED = 4096;
+    const size_t OBJECTS_PER_SLAB = 256;
+    
+    const size_t NUM_SIZES = MAX_POOLED / ALIGN + 1;
+    
+    // One pool per partition and size class, created on first use; freed at
+    // exit (all together, since slots may have moved between partitions)
+    struct Pools {
+        SlabPool* bySize[parallel::MAX_THREADS][NUM_SIZES];
+        Pools(){
+            for( size_t k = 0; k < parallel::MAX_THREADS; ++k )
+                for( size_t i = 0; i < NUM_SIZES; ++i )
+                    bySize[k][i] = 0;
+        }
+        ~Pools(){
+            for( size_t k = 0; k < parallel::MAX_THREADS; ++k )
+                for( size_t i = 0; i < NUM_SIZES; ++i )
+                    delete bySize[k][i];
+        }
+        inline SlabPool*& get( size_t size ){
+            return bySize[parallel::partition()][roundUp( size ) / ALIGN];
+        }
+    } pools;
+    
+    void* allocate( size_t size ){
+        if( size > MAX_POOLED ) return ::operator new( size );
+        SlabPool*& pool = pools.get( size );
+        if( pool == 0 ) pool = new SlabPool( size, OBJECTS_PER_SLAB );
+        return pool->allocate();
+    }
+    void deallocate( void* p, size_t size ){
+        if( p == 0 ) return;
+        if( size > MAX_POOLED ){
+            ::operator delete( p );
+            return;
+        }
+        SlabPool*& pool = pools.get( size );
+        // freed in a partition which has not allocated this size yet
+        if( pool == 0 ) pool = new SlabPool( size, OBJECTS_PER_SLAB );
+        pool->deallocate( p );
+    }
+}
+
+} }
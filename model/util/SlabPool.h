@@ -0,0 +1,114 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_SlabPool
+#define Hmod_util_SlabPool
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace OM { namespace util {
+
+/** Allocates objects of one size from large contiguous blocks ("slabs").
+ *
+ * Freed slots are recycled before new ones are used. Objects allocated one
+ * after another are thus usually adjacent in memory, which helps when
+ * sweeping over many of them (e.g. all humans). Memory is only returned to
+ * the system when the pool is destroyed.
+ *
+ * Not thread-safe: allocate and free only from serial code. */
+class SlabPool {
+public:
+    /** @param size Size of each object in bytes
+     * @param perSlab Number of objects per slab */
+    SlabPool( size_t size, size_t perSlab );
+    /// Frees all slabs. Objects in them must already have been destroyed.
+    ~SlabPool();
+    
+    /// Get memory for one object
+    void* allocate();
+    /// Return memory previously returned by allocate()
+    void deallocate( void* p );
+    
+private:
+    SlabPool( const SlabPool& );        // not copyable
+    void operator=( const SlabPool& );
+    
+    size_t size, perSlab;
+    std::vector<char*> slabs;
+    size_t nextInSlab;  // next never-used slot in slabs.back()
+    void* freeList;     // freed slots, linked through their first word
+};
+
+/** Memory for polymorphic per-human sub-models (within-host, clinical,
+ * infection incidence) and other small objects frequently created and
+ * destroyed (infections, list nodes). Use from a base class's operator
+ * new/delete or via SlabAllocator; each object size (thus usually each
+ * derived type) gets its own SlabPool.
+ *
+ * Each partition of a parallel human update (see util::parallel) has its own
+ * pools, so objects may be allocated and freed during the update. An object
+ * may be freed from a different partition than allocated it; its memory is
+ * then reused by that partition. */
+namespace slab {
+    void* allocate( size_t size );
+    void deallocate( void* p, size_t size );
+}
+
+/** STL allocator using slab::allocate, for node-based containers such as
+ * std::list. */
+template<class T>
+class SlabAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    template<class U> struct rebind {
+        typedef SlabAllocator<U> other;
+    };
+    
+    SlabAllocator() {}
+    template<class U> SlabAllocator( const SlabAllocator<U>& ) {}
+    
+    pointer address( reference x ) const{ return &x; }
+    const_pointer address( const_reference x ) const{ return &x; }
+    pointer allocate( size_type n, const void* = 0 ){
+        return static_cast<pointer>( slab::allocate( n * sizeof(T) ) );
+    }
+    void deallocate( pointer p, size_type n ){
+        slab::deallocate( p, n * sizeof(T) );
+    }
+    size_type max_size() const{ return size_type(-1) / sizeof(T); }
+    void construct( pointer p, const T& val ){ new( static_cast<void*>(p) ) T( val ); }
+    void destroy( pointer p ){ p->~T(); }
+};
+// All SlabAllocators share the same pools, thus are interchangeable
+template<class T, class U>
+inline bool operator==( const SlabAllocator<T>&, const SlabAllocator<U>& ){ return true; }
+template<class T, class U>
+inline bool operator!=( const SlabAllocator<T>&, const SlabAllocator<U>& ){ return false; }
+
+} }
+#endif
@@ -24,13 +24,18 @@
 
 #include <limits>
 #include <sstream>
+#include <algorithm>
 #include <assert.h>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/predef/other/endian.h>
 using namespace std;
 
 namespace OM { namespace util { namespace checkpoint {
     
     // Header test constants
     const unsigned int h_BOM = 0x50434D4F;      // "OMCP" in little-endian: OpenMalaria CheckPoint
+    // FORMAT_VERSION (see checkpoint.h) is written next
     const bool h_b = true;
     const unsigned char h_c = 0xA5;     // binary: 10100101; don't care if char is signed as long as first bit is read and written correctly
     const double h_n0 = -0.0;
@@ -47,12 +52,23 @@ namespace OM { namespace util { namespace checkpoint {
     
     /** @brief Binary checkpointing
      *
-     * Writes value in direct binary (not suitible for pointers). Currently
-     * machine dependent (don't transfer a checkpoint to another machine).
+     * Writes value in direct binary, little-endian (not suitible for
+     * pointers). The width is that of T; callers use fixed-width types where
+     * native widths differ between platforms.
      */
     //@{
     template<class T>
+    inline void swapToLittleEndian (T& x) {
+#if BOOST_ENDIAN_BIG_BYTE
+        char *p = reinterpret_cast<char*>(&x);
+        std::reverse (p, p + sizeof(T));
+#else
+        (void)x;
+#endif
+    }
+    template<class T>
     void binary_write (T x, ostream& stream) {
+        swapToLittleEndian (x);
         stream.write (reinterpret_cast<char*>(&x), sizeof(x));
     }
     template<class T>
@@ -60,13 +76,27 @@ namespace OM { namespace util { namespace checkpoint {
         stream.read (reinterpret_cast<char*>(&x), sizeof(x));
         if (!stream || stream.gcount() != sizeof(x))
             throw checkpoint_error ("stream read error binary");
+        swapToLittleEndian (x);
+    }
+    /// Read a 64-bit value into a type which may be narrower
+    template<class T>
+    void binary_read64 (T& x, istream& stream) {
+        typedef typename boost::mpl::if_c<numeric_limits<T>::is_signed,
+                boost::int64_t, boost::uint64_t>::type T64;
+        T64 y;
+        binary_read (y, stream);
+        x = static_cast<T>(y);
+        if (static_cast<T64>(x) != y)
+            throw checkpoint_error ("value out of range for this platform");
     }
     //@}
     
     void staticChecks () {
         BOOST_STATIC_ASSERT (sizeof(char) == 1);
+        BOOST_STATIC_ASSERT (sizeof(bool) == 1);
         BOOST_STATIC_ASSERT (sizeof(short int) == 2);
         BOOST_STATIC_ASSERT (sizeof(int) == 4);
+        BOOST_STATIC_ASSERT (sizeof(long long) == 8);
         BOOST_STATIC_ASSERT (sizeof(float) == 4);
         BOOST_STATIC_ASSERT (sizeof(double) == 8);
     }
@@ -75,6 +105,7 @@ namespace OM { namespace util { namespace checkpoint {
         staticChecks();
         
         binary_write (h_BOM, stream);
+        binary_write (FORMAT_VERSION, stream);
         binary_write (h_b, stream);
         binary_write (h_c, stream);
         binary_write (h_n0, stream);
@@ -82,21 +113,29 @@ namespace OM { namespace util { namespace checkpoint {
     }
     void header (istream& stream) {
         staticChecks ();
-        unsigned int BOM;
+        unsigned int BOM, version;
         bool b;
         unsigned char c;
         double n0;
         double nan;
         
         binary_read (BOM, stream);
+        if (BOM != h_BOM)
+            throw checkpoint_error ("invalid header");
+        binary_read (version, stream);
+        if (version != FORMAT_VERSION) {
+            ostringstream msg;
+            msg << "checkpoint format version " << version
+                << " is not supported (expected " << FORMAT_VERSION << ")";
+            throw checkpoint_error (msg.str());
+        }
         binary_read (b, stream);
         binary_read (c, stream);
         binary_read (n0, stream);
         binary_read (nan, stream);
         
         // Check. Use binary check for doubles since it's not the same as numeric ==
-        if (BOM != h_BOM ||
-            b != h_b ||
+        if (b != h_b ||
             c != h_c ||
             memcmp (&n0, &h_n0, sizeof(double)) ||
             memcmp (&nan, &h_nan, sizeof(double))
@@ -135,10 +174,10 @@ namespace OM { namespace util { namespace checkpoint {
     }
     
     void operator& (long x, ostream& stream) {
-        binary_write (x, stream);
+        binary_write (static_cast<boost::int64_t>(x), stream);
     }
     void operator& (long& x, istream& stream) {
-        binary_read (x, stream);
+        binary_read64 (x, stream);
     }
     
     void operator& (long long x, ostream& stream) {
@@ -170,10 +209,10 @@ namespace OM { namespace util { namespace checkpoint {
     }
     
     void operator& (unsigned long x, ostream& stream) {
-        binary_write (x, stream);
+        binary_write (static_cast<boost::uint64_t>(x), stream);
     }
     void operator& (unsigned long& x, istream& stream) {
-        binary_read (x, stream);
+        binary_read64 (x, stream);
     }
     
     void operator& (unsigned long long x, ostream& stream) {
@@ -205,6 +244,32 @@ namespace OM { namespace util { namespace checkpoint {
     }
     //@}
     
+    void operator& (const vector<double>& x, ostream& stream) {
+        x.size() & stream;
+#if BOOST_ENDIAN_BIG_BYTE
+        for( vector<double>::const_iterator it = x.begin(); it != x.end(); ++it )
+            binary_write (*it, stream);
+#else
+        if( !x.empty() )
+            stream.write (reinterpret_cast<const char*>(&x[0]), x.size() * sizeof(double));
+#endif
+    }
+    void operator& (vector<double>& x, istream& stream) {
+        size_t len;
+        len & stream;
+        validateListSize (len);
+        x.resize (len);
+#if BOOST_ENDIAN_BIG_BYTE
+        for( vector<double>::iterator it = x.begin(); it != x.end(); ++it )
+            binary_read (*it, stream);
+#else
+        if( len == 0 ) return;
+        stream.read (reinterpret_cast<char*>(&x[0]), len * sizeof(double));
+        if (!stream || stream.gcount() != streamsize(len * sizeof(double)))
+            throw checkpoint_error ("stream read error vector");
+#endif
+    }
+    
     // string
     void operator& (string x, ostream& stream) {
         x.length() & stream;
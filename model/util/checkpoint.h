@@ -68,7 +68,16 @@ virtual checkpoint (ostream& stream);
  * 
  * Checkpointing should be set up by including Global.h. Some more
  * checkpointing functions (for handling containers) are available by including
- * checkpoint_containers.h. */
+ * checkpoint_containers.h.
+ * 
+ * File format: header() writes a magic number and format version, followed
+ * by some test values. All values are written in binary, little-endian, with
+ * a fixed width for each type: 1 byte for bool and char types, 2 for short,
+ * 4 for int and float, 8 for long, long long (and the unsigned equivalents)
+ * and double. Reading is a single pass over the stream with
+ * no parsing. Checkpoints written by one build can therefore be read by
+ * another on a different platform, provided the same set of data is
+ * checkpointed (which is checked separately by the Simulator). */
 namespace OM {
 namespace interventions{
     struct ComponentId;
@@ -78,6 +87,16 @@ namespace checkpoint {
     
     const long DEFAULT_MAX_LENGTH = 2000;
     
+    /** Version of the checkpoint file format. Increment when changing the
+     * encoding of values, or the data stored in a way which makes older
+     * checkpoints (and warm-up snapshots) unreadable.
+     * 
+     * 1: native-endian values of native width (no version in header)
+     * 2: little-endian values of fixed width
+     * 3: as 2; humans no longer store the next continuous deployment, and
+     *    monitoring stores the first held survey and output stream state */
+    const unsigned int FORMAT_VERSION = 3;
+    
     ///@brief Utility functions
     //@{
     /** Perform important checks on checkpoint file format.
@@ -142,10 +161,21 @@ namespace checkpoint {
     void operator& (double x, ostream& stream);
     void operator& (double& x, istream& stream);
     
+    
+    /** Note: long double is written with its native width (and
+     * representation), so is not portable between platforms. */
     void operator& (long double x, ostream& stream);
     void operator& (long double& x, istream& stream);
     //@}
     
+    /** @brief Operator& for vectors of double
+     *
+     * Elements are written as one block rather than individually. */
+    //@{
+    void operator& (const vector<double>& x, ostream& stream);
+    void operator& (vector<double>& x, istream& stream);
+    //@}
+    
     /** @brief Operator& for pointers
      *
      * These could be implemented for pointers but require reading objects in the opposite order to
@@ -68,15 +68,15 @@ namespace checkpoint {
         }
     }
     
-    template<class T>
-    void operator& (list<T> x, ostream& stream) {
+    template<class T, class A>
+    void operator& (list<T,A> x, ostream& stream) {
         x.size() & stream;
         foreach (T& y, x) {
             y & stream;
         }
     }
-    template<class T>
-    void operator& (list<T>& x, istream& stream) {
+    template<class T, class A>
+    void operator& (list<T,A>& x, istream& stream) {
         size_t l;
         l & stream;
         validateListSize (l);
@@ -0,0 +1,79 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "util/parallel.h"
+#include "util/errors.h"
+
+#include <sstream>
+
+namespace OM { namespace util { namespace parallel {
+
+size_t nThreads = 1;
+bool isActive = false;
+
+// Partition of the calling thread. Each OpenMP thread has its own copy.
+size_t currentPartition = 0;
+#ifdef _OPENMP
+#pragma omp threadprivate(currentPartition)
+#endif
+
+void init( size_t n ){
+    if( n == 0 || n > MAX_THREADS ){
+        ostringstream msg;
+        msg << "--threads: number must be between 1 and " << MAX_THREADS;
+        throw cmd_exception( msg.str() );
+    }
+#ifndef _OPENMP
+    if( n > 1 ){
+        throw cmd_exception( "--threads: this build does not support "
+            "multi-threading (compile with OM_OPENMP enabled)" );
+    }
+#endif
+#ifdef OM_STREAM_VALIDATOR
+    if( n > 1 ){
+        throw cmd_exception( "--threads: cannot use more than one thread "
+            "when compiled with OM_STREAM_VALIDATOR" );
+    }
+#endif
+    nThreads = n;
+}
+
+size_t numThreads(){
+    return nThreads;
+}
+
+bool active(){
+    return isActive;
+}
+
+size_t partition(){
+    return currentPartition;
+}
+
+void setActive( bool a ){
+    isActive = a;
+    currentPartition = 0;
+}
+
+void enterPartition( size_t k ){
+    currentPartition = k;
+}
+
+} } }
@@ -0,0 +1,86 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_parallel
+#define Hmod_util_parallel
+
+#include <cstddef>
+#include <boost/cstdint.hpp>
+
+namespace OM { namespace util {
+
+/** Support for updating humans on several threads.
+ *
+ * The human population is split into numThreads() contiguous partitions
+ * (in population order) and partition k is always updated with random number
+ * stream k, whichever OpenMP thread actually runs it. Anything reported to
+ * shared state while a partitioned update is active() must either be
+ * order-independent (integer tallies, see atomicAdd) or be buffered per
+ * partition and merged in partition order afterwards. This keeps results
+ * reproducible for a given seed and thread count.
+ *
+ * With one thread (the default) none of this is used and the simulation
+ * runs exactly as it does without OpenMP. */
+namespace parallel {
+    /// Upper bound on the number of threads (and partitions) supported.
+    const size_t MAX_THREADS = 64;
+
+    /** Set the number of threads (from the command line).
+     *
+     * Throws cmd_exception if the number is not supported by this build. */
+    void init( size_t nThreads );
+
+    /// Number of threads (and partitions) used for the human update.
+    size_t numThreads();
+
+    /// True while a partitioned human update is in progress.
+    bool active();
+
+    /** Index of the partition the calling thread is updating (in the range
+     * [0, numThreads())), or 0 outside of a partitioned update. */
+    size_t partition();
+
+    ///@brief Used by Population to run a partitioned update
+    //@{
+    /// Start (true) or end (false) a partitioned update. Call outside of
+    /// any parallel region.
+    void setActive( bool isActive );
+    /// Mark the calling thread as updating partition k.
+    void enterPartition( size_t k );
+    //@}
+
+    /// Add v to x atomically (for tallies shared between partitions).
+    inline void atomicAdd( int& x, int v ){
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        x += v;
+    }
+    /// Add v to x atomically (for tallies shared between partitions).
+    inline void atomicAdd( boost::int64_t& x, boost::int64_t v ){
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        x += v;
+    }
+}
+
+} }
+#endif
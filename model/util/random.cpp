@@ -23,6 +23,9 @@
  * Currently both the GSL and boost generators are implemented. The
  * distributions all come from the GSL library so far.
  * 
+ * Alternatively (--rng=philox) a counter-based Philox generator is used,
+ * wrapped as a GSL generator type so that the same distributions apply.
+ * 
  * Using the boost generator appears (in rough tests) to be slightly
  * slower, which is understandable since the GSL distributions must then use a
  * wrapper around the boost generator.
@@ -38,6 +41,7 @@
 #include "util/random.h"
 #include "util/errors.h"
 #include "util/StreamValidator.h"
+#include "util/parallel.h"
 #include "Global.h"
 
 #ifdef OM_RANDOM_USE_BOOST
@@ -53,6 +57,7 @@
 
 #include <cmath>
 #include <sstream>
+#include <limits>
 
 // Note: since we're using both gsl and boost files, we should be careful to
 // avoid name conflicts. So probably don't use "using namespace boost;".
@@ -85,10 +90,123 @@ namespace OM { namespace util {
     };
 # endif
 
+// -----  Philox4x32-10 counter-based generator  -----
+
+void random::philox4x32_10 (const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    // Constants from Salmon et al., "Parallel random numbers: as easy as
+    // 1, 2, 3" (SC11), as used by Random123.
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+	if (round > 0) {
+	    k0 += W0;
+	    k1 += W1;
+	}
+	uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+	uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+	uint32_t hi0 = static_cast<uint32_t>(p0 >> 32), lo0 = static_cast<uint32_t>(p0);
+	uint32_t hi1 = static_cast<uint32_t>(p1 >> 32), lo1 = static_cast<uint32_t>(p1);
+	c0 = hi1 ^ c1 ^ k0;
+	c1 = lo1;
+	c2 = hi0 ^ c3 ^ k1;
+	c3 = lo0;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+random::Streams::Streams (uint64_t id) : id(id), step(0) {
+    for (size_t i = 0; i < NUM_PURPOSES; ++i)
+	draws[i] = 0;
+}
+
+// State of a GSL generator using Philox. Allocated (uninitialised) by GSL;
+// philox_set() initialises it.
+struct PhiloxState {
+    uint32_t seed;
+    random::Streams global;	// stream used outside of any HumanContext
+    random::Streams *streams;	// current stream
+    uint32_t purpose;	// current purpose
+    // Last block computed, with the inputs it was computed from:
+    uint64_t blockId;
+    int blockStep;
+    uint32_t blockPurpose, blockNum;
+    bool blockValid;
+    uint32_t block[4];
+};
+
+// Identifier of the global stream of partition p; human ids count up from 0
+// so these never collide in practice.
+inline uint64_t globalStreamId (size_t p) {
+    return ~static_cast<uint64_t>(0) - p;
+}
+
+void philox_set (void *vstate, unsigned long int seed) {
+    PhiloxState *s = static_cast<PhiloxState*>(vstate);
+    s->seed = static_cast<uint32_t>(seed);
+    s->global = random::Streams( globalStreamId(0) );
+    s->streams = &s->global;
+    s->purpose = random::PURPOSE_GLOBAL;
+    s->blockValid = false;
+}
+
+inline uint32_t philox_next (PhiloxState *s) {
+    random::Streams& h = *s->streams;
+    int step = sim::nowOrTs0().raw();
+    if (h.step != step) {
+	// draw counters restart each time step
+	h.step = step;
+	for (size_t i = 0; i < random::NUM_PURPOSES; ++i)
+	    h.draws[i] = 0;
+    }
+    uint32_t n = h.draws[s->purpose]++;
+    uint32_t blockNum = n >> 2;
+    if (!s->blockValid || s->blockId != h.id || s->blockStep != step ||
+	s->blockPurpose != s->purpose || s->blockNum != blockNum)
+    {
+	const uint32_t ctr[4] = { blockNum, static_cast<uint32_t>(step),
+	    static_cast<uint32_t>(h.id), static_cast<uint32_t>(h.id >> 32) };
+	const uint32_t key[2] = { s->seed, s->purpose };
+	random::philox4x32_10 (ctr, key, s->block);
+	s->blockId = h.id;
+	s->blockStep = step;
+	s->blockPurpose = s->purpose;
+	s->blockNum = blockNum;
+	s->blockValid = true;
+    }
+    uint32_t val = s->block[n & 3];
+    streamValidate( val );
+    return val;
+}
+
+unsigned long int philox_get (void *vstate) {
+    return philox_next (static_cast<PhiloxState*>(vstate));
+}
+double philox_get_double (void *vstate) {
+    return philox_next (static_cast<PhiloxState*>(vstate)) / 4294967296.0;
+}
+
+static const gsl_rng_type philox_type = {
+    "philox4x32_10",		// name
+    0xFFFFFFFFUL,		// max value
+    0,				// min value
+    sizeof(PhiloxState),	// size of state
+    &philox_set,
+    &philox_get,
+    &philox_get_double
+};
+
+random::Generator generatorType = random::MT19937;
+
 // This should be created and deleted automatically, taking care of
 // allocating and freeing the generator.
 struct generator_factory {
     gsl_rng * gsl_generator;
+    // Generators for partitions 1, 2, ... of a multi-threaded human update
+    // (partition 0 and all serial code use gsl_generator). Same type as
+    // gsl_generator.
+    vector<gsl_rng*> partition_generators;
     
     generator_factory () {
 #	ifdef OM_RANDOM_USE_BOOST
@@ -108,22 +226,104 @@ struct generator_factory {
 #	else
 	gsl_rng_free (gsl_generator);
 #	endif
+	for( size_t i = 0; i < partition_generators.size(); ++i )
+	    gsl_rng_free (partition_generators[i]);
+    }
+    
+    // The generator for the calling thread's partition.
+    inline gsl_rng * get () {
+	size_t p = parallel::partition();
+	return p == 0 ? gsl_generator : partition_generators[p - 1];
     }
 } rng;
 
+// Derive a seed for partition p from the scenario seed. Any decent mixing
+// function will do; this is the MurmurHash3 finaliser.
+uint32_t partitionSeed (uint32_t seed, size_t p) {
+    uint32_t h = seed ^ (static_cast<uint32_t>(p) * 0x9E3779B9u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
 // -----  set-up, tear-down and checkpointing  -----
 
-void random::seed (uint32_t seed) {
+void random::seed (uint32_t seed, Generator gen) {
 //     util::streamValidate(seed);
 # ifdef OM_RANDOM_USE_BOOST
+    if (gen != MT19937)
+	throw cmd_exception ("--rng: only mt19937 is supported when compiled with OM_RANDOM_USE_BOOST");
     if (seed == 0) seed = 4357;	// gsl compatibility − ugh
     boost_generator.seed (seed);
 # else
+    if (gen != generatorType) {
+	gsl_rng_free (rng.gsl_generator);
+	rng.gsl_generator = gsl_rng_alloc(gen == PHILOX ? &philox_type : gsl_rng_mt19937);
+    }
     gsl_rng_set (rng.gsl_generator, seed);
 # endif
+    generatorType = gen;
+    
+    // Extra streams for a multi-threaded update (none with one thread):
+    size_t nPartitions = parallel::numThreads();
+# ifdef OM_RANDOM_USE_BOOST
+    if (nPartitions > 1)
+	throw cmd_exception ("--threads: not supported when compiled with OM_RANDOM_USE_BOOST");
+# endif
+    while (rng.partition_generators.size() + 1 < nPartitions)
+	rng.partition_generators.push_back (gsl_rng_alloc(gen == PHILOX ? &philox_type : gsl_rng_mt19937));
+    for (size_t p = 1; p < nPartitions; ++p) {
+	gsl_rng *g = rng.partition_generators[p - 1];
+	if (gen == PHILOX) {
+	    // All partitions share the key; humans' draws are then independent
+	    // of the partition updating them.
+	    gsl_rng_set (g, seed);
+	    static_cast<PhiloxState*>(g->state)->global = Streams( globalStreamId(p) );
+	} else {
+	    gsl_rng_set (g, partitionSeed (seed, p));
+	}
+    }
 }
 
+#ifndef OM_RANDOM_USE_BOOST
+// Generator state as raw bytes (like gsl_rng_fwrite), within the stream
+namespace {
+    void readStateInline (istream& stream, gsl_rng *g) {
+	size_t len;
+	len & stream;
+	if (len != gsl_rng_size (g))
+	    throw checkpoint_error ("generator state has the wrong size");
+	stream.read (static_cast<char*>(gsl_rng_state (g)), len);
+	if (!stream || stream.gcount() != streamsize(len))
+	    throw checkpoint_error ("stream read error");
+    }
+    void writeStateInline (ostream& stream, gsl_rng *g) {
+	size_t len = gsl_rng_size (g);
+	len & stream;
+	stream.write (static_cast<const char*>(gsl_rng_state (g)), len);
+    }
+}
+#endif
+
 void random::checkpoint (istream& stream, int seedFileNumber) {
+    size_t nPartitionGenerators;
+    nPartitionGenerators & stream;
+    if (nPartitionGenerators != rng.partition_generators.size())
+	throw checkpoint_error ("checkpoint was written using a different number of threads (--threads)");
+    int gen;
+    gen & stream;
+    if (gen != generatorType)
+	throw checkpoint_error ("checkpoint was written using a different generator (--rng)");
+    if (generatorType == PHILOX) {
+	// All other state is per-human or derived from the seed
+	static_cast<PhiloxState*>(rng.gsl_generator->state)->global & stream;
+	for (size_t i = 0; i < rng.partition_generators.size(); ++i)
+	    static_cast<PhiloxState*>(rng.partition_generators[i]->state)->global & stream;
+	return;
+    }
 # ifdef OM_RANDOM_USE_BOOST
     // Don't use OM::util::checkpoint function for loading a stream; checkpoint::validateListSize uses too small a number.
     string str;
@@ -136,6 +336,12 @@ void random::checkpoint (istream& stream, int seedFileNumber) {
     istringstream ss (str);
     ss >> boost_generator;
 # else
+    if (seedFileNumber < 0) {
+	readStateInline (stream, rng.gsl_generator);
+	for (size_t i = 0; i < rng.partition_generators.size(); ++i)
+	    readStateInline (stream, rng.partition_generators[i]);
+	return;
+    }
     
     ostringstream seedN;
     seedN << string("seed") << seedFileNumber;
@@ -144,27 +350,76 @@ void random::checkpoint (istream& stream, int seedFileNumber) {
 	throw checkpoint_error (string("load_rng_state: file not found: ").append(seedN.str()));
     if (gsl_rng_fread(f, rng.gsl_generator) != 0)
 	throw checkpoint_error ("gsl_rng_fread failed");
+    for (size_t i = 0; i < rng.partition_generators.size(); ++i)
+	if (gsl_rng_fread(f, rng.partition_generators[i]) != 0)
+	    throw checkpoint_error ("gsl_rng_fread failed");
     fclose (f);
 # endif
 }
 
-void random::checkpoint (ostream& stream, int seedFileNumber) {
+void random::checkpoint (ostream& stream, int seedFileNumber, string* seedData) {
+    rng.partition_generators.size() & stream;
+    static_cast<int>(generatorType) & stream;
+    if (generatorType == PHILOX) {
+	static_cast<PhiloxState*>(rng.gsl_generator->state)->global & stream;
+	for (size_t i = 0; i < rng.partition_generators.size(); ++i)
+	    static_cast<PhiloxState*>(rng.partition_generators[i]->state)->global & stream;
+	return;
+    }
 # ifdef OM_RANDOM_USE_BOOST
     ostringstream ss;
     ss << boost_generator;
     ss.str() & stream;
 # else
+    if (seedFileNumber < 0) {
+	writeStateInline (stream, rng.gsl_generator);
+	for (size_t i = 0; i < rng.partition_generators.size(); ++i)
+	    writeStateInline (stream, rng.partition_generators[i]);
+	return;
+    }
+    
+    if (seedData != 0) {
+	// the same bytes as gsl_rng_fwrite writes
+	seedData->assign (static_cast<const char*>(gsl_rng_state (rng.gsl_generator)),
+			  gsl_rng_size (rng.gsl_generator));
+	for (size_t i = 0; i < rng.partition_generators.size(); ++i)
+	    seedData->append (static_cast<const char*>(gsl_rng_state (rng.partition_generators[i])),
+			      gsl_rng_size (rng.partition_generators[i]));
+	return;
+    }
     
     ostringstream seedN;
     seedN << string("seed") << seedFileNumber;
     FILE * f = fopen(seedN.str().c_str(), "wb");
     if (gsl_rng_fwrite(f, rng.gsl_generator) != 0)
 	throw checkpoint_error ("gsl_rng_fwrite failed");
+    for (size_t i = 0; i < rng.partition_generators.size(); ++i)
+	if (gsl_rng_fwrite(f, rng.partition_generators[i]) != 0)
+	    throw checkpoint_error ("gsl_rng_fwrite failed");
     fclose (f);
 # endif
 }
 
 
+random::HumanContext::HumanContext (Streams& streams, Purpose purpose) :
+    state(0), prevStreams(0), prevPurpose(0)
+{
+    if (generatorType != PHILOX) return;
+    PhiloxState *s = static_cast<PhiloxState*>(rng.get()->state);
+    state = s;
+    prevStreams = s->streams;
+    prevPurpose = s->purpose;
+    s->streams = &streams;
+    s->purpose = purpose;
+}
+random::HumanContext::~HumanContext () {
+    if (state == 0) return;
+    PhiloxState *s = static_cast<PhiloxState*>(state);
+    s->streams = prevStreams;
+    s->purpose = prevPurpose;
+}
+
+
 // -----  random number generation  -----
 
 double random::uniform_01 () {
@@ -173,25 +428,25 @@ double random::uniform_01 () {
 # ifdef OM_RANDOM_USE_BOOST
         rng_uniform01 ();
 # else
-        gsl_rng_uniform (rng.gsl_generator);
+        gsl_rng_uniform (rng.get());
 # endif
 //     util::streamValidate(result);
     return result;
 }
 
 double random::gauss (double mean, double std){
-    double result = gsl_ran_gaussian(rng.gsl_generator,std)+mean;
+    double result = gsl_ran_gaussian(rng.get(),std)+mean;
 //     util::streamValidate(result);
     return result;
 }
 double random::gauss (double std){
-    double result = gsl_ran_gaussian(rng.gsl_generator,std);
+    double result = gsl_ran_gaussian(rng.get(),std);
 //     util::streamValidate(result);
     return result;
 }
 
 double random::gamma (double a, double b){
-    double result = gsl_ran_gamma(rng.gsl_generator, a, b);
+    double result = gsl_ran_gamma(rng.get(), a, b);
 //     util::streamValidate(result);
     return result;
 }
@@ -202,7 +457,7 @@ double random::log_normal (double mu, double sigma){
     boost::lognormal_distribution<> dist (mean, std);
     return dist (boost_generator);
 # else*/
-    double result = gsl_ran_lognormal (rng.gsl_generator, mu, sigma);
+    double result = gsl_ran_lognormal (rng.get(), mu, sigma);
 //     util::streamValidate(result);
     return result;
 //# endif
@@ -224,7 +479,7 @@ double random::sampleFromLogNormal(double normp, double meanlog, double stdlog){
 }
 
 double random::beta (double a, double b){
-    double result = gsl_ran_beta (rng.gsl_generator,a,b);
+    double result = gsl_ran_beta (rng.get(),a,b);
 //     util::streamValidate(result);
     return result;
 }
@@ -240,7 +495,7 @@ int random::poisson(double lambda){
 	//This would lead to an inifinite loop in gsl_ran_poisson
 	throw TRACED_EXCEPTION( "lambda is inf", Error::InfLambda );
     }
-    int result = gsl_ran_poisson (rng.gsl_generator, lambda);
+    int result = gsl_ran_poisson (rng.get(), lambda);
 //     util::streamValidate(result);
     return result;
 }
@@ -258,12 +513,23 @@ int random::uniform(int n){
     return static_cast<int>( random::uniform_01() * n );
 }
 
+size_t random::geometric(double prob){
+    assert( prob > 0.0 && prob <= 1.0 );
+    if( prob >= 1.0 ) return 0;
+    // Inversion: 1 - uniform_01() is in (0,1], so the log is finite
+    const double logFail = log( 1.0 - prob );
+    double k = floor( log( 1.0 - random::uniform_01() ) / logFail );
+    if( logFail == 0.0 || k >= static_cast<double>( numeric_limits<size_t>::max() ) )
+        return numeric_limits<size_t>::max();
+    return static_cast<size_t>( k );
+}
+
 double random::exponential(double mean){
-    return gsl_ran_exponential(rng.gsl_generator, mean);
+    return gsl_ran_exponential(rng.get(), mean);
 }
 
 double random::weibull(double lambda, double k){
-    return gsl_ran_weibull( rng.gsl_generator, lambda, k );
+    return gsl_ran_weibull( rng.get(), lambda, k );
 }
 
 } }
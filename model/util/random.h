@@ -18,6 +18,9 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#ifndef Hmod_util_random
+#define Hmod_util_random
+
 #include "Global.h"
 #include <set>
 
@@ -27,13 +30,89 @@ namespace OM { namespace util {
  *
  * This interface should be independant of implementation. */
 namespace random {
+    /// Underlying generator (selected on the command line)
+    enum Generator {
+        /** Mersenne twister: a single stream, consumed in program order.
+         * Results depend on the order in which draws are made. */
+        MT19937,
+        /** Philox4x32-10 counter-based generator. Each draw is computed from
+         * (seed, purpose) and (human id, time step, draw number), so a
+         * human's draws do not depend on what other humans do, the order in
+         * which humans are updated or the number of threads. */
+        PHILOX
+    };
+    
+    /** Purpose of draws made under a HumanContext (PHILOX only). Each purpose
+     * has its own sub-stream so that, e.g., deploying an extra intervention
+     * does not shift the numbers drawn by the next human update. */
+    enum Purpose {
+        PURPOSE_GLOBAL = 0,     ///< draws not attributed to any human
+        PURPOSE_BIRTH,          ///< creation of a human
+        PURPOSE_UPDATE,         ///< per-time-step human update
+        PURPOSE_DEPLOY,         ///< intervention deployment
+        PURPOSE_SURVEY,         ///< survey reporting
+        NUM_PURPOSES
+    };
+    
+    /** Per-human counter-based stream state (identifier and number of draws
+     * made this time step for each purpose). Only used with PHILOX. */
+    struct Streams {
+        explicit Streams (uint64_t id = 0);
+        
+        /// Checkpointing
+        template<class S>
+        void operator& (S& stream) {
+            id & stream;
+            step & stream;
+            for (size_t i = 0; i < NUM_PURPOSES; ++i)
+                draws[i] & stream;
+        }
+        
+        uint64_t id;
+        int step;       // time step (raw) to which draws apply
+        uint32_t draws[NUM_PURPOSES];
+    };
+    
+    /** While an object of this type exists, draws made by the calling thread
+     * use the given human's stream for the given purpose. Contexts nest; the
+     * previous one is restored on destruction. Does nothing with MT19937.
+     * 
+     * Draws made outside of any context come from a global stream. */
+    class HumanContext {
+    public:
+        HumanContext (Streams& streams, Purpose purpose);
+        ~HumanContext ();
+    private:
+        HumanContext (const HumanContext&);     // not copyable
+        void operator= (const HumanContext&);
+        
+        void *state;
+        Streams *prevStreams;
+        uint32_t prevPurpose;
+    };
+    
     ///@brief Setup & cleanup; checkpointing
     //@{
-    /// Reseed the random-number-generator with seed (usually InputData.getISeed()).
-    void seed (uint32_t seed);
+    /** Reseed the random-number-generator with seed (usually InputData.getISeed()).
+     * 
+     * When humans are updated on several threads (see util::parallel), this
+     * also seeds one extra stream per additional partition; draws made while
+     * updating partition k come from stream k. Call after parallel::init().
+     * 
+     * @param gen Underlying generator to use */
+    void seed (uint32_t seed, Generator gen = MT19937);
     
+    /** Read/write generator state.
+     * 
+     * With the GSL Mersenne twister, state is kept in a separate file,
+     * seedN for N = seedFileNumber, unless seedFileNumber is negative, in
+     * which case it is part of the stream.
+     * 
+     * When writing, if seedData is not null, the content of the seed file is
+     * stored there instead of written (it is left empty when no seed file is
+     * used), so that the caller can write it together with the checkpoint. */
     void checkpoint (istream& stream, int seedFileNumber);
-    void checkpoint (ostream& stream, int seedFileNumber);
+    void checkpoint (ostream& stream, int seedFileNumber, string* seedData = 0);
     //@}
     
     ///@brief Random number distributions
@@ -82,6 +161,11 @@ namespace random {
      * equal probability of being sampled. */
     int uniform (int n);
     
+    /** Return the number of failures before the first success in a sequence
+     * of Bernoulli trials with success probability prob (0 < prob <= 1).
+     * Uses one uniform variate. */
+    size_t geometric( double prob );
+    
     /** Return a variate sampled from the exponential distribution, whose PDF
      * is: pdf(x) = exp(-x/mean) / mean */
     double exponential( double mean );
@@ -96,5 +180,10 @@ namespace random {
      */
     double weibull( double lambda, double k );
     //@}
+    
+    /** The Philox4x32-10 block function: encrypt counter ctr with key,
+     * writing four 32-bit outputs to out. Exposed for testing. */
+    void philox4x32_10 (const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
 }
 } }
+#endif
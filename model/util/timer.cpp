@@ -29,9 +29,12 @@
 #endif
 
 #include "util/timer.h"
+#include "util/parallel.h"
 #include <iostream>
+#include <iomanip>
 #include <cstdlib>
 #include <cstdio>
+#include <ctime>
 
 using namespace std;
 
@@ -115,4 +118,98 @@ void timer::stopCheckpoint (){
 }
 
 #endif
+
+
+// Profiling (see --profile)
+
+#ifdef OM_PROFILING
+namespace profile {
+
+bool enabled = false;
+
+namespace {
+    struct Totals {
+        double seconds;
+        unsigned long long calls, items;
+    };
+    // Indexed by partition, so threads never write the same entry.
+    // Zero-initialised (static storage).
+    Totals totals[parallel::MAX_THREADS][NUM_SECTIONS];
+    
+    const char *names[NUM_SECTIONS] = {
+        "population update",
+        "vector update",
+        "intervention deployment",
+        "continuous output",
+        "survey",
+        "within-host update",
+        "PK/PD drug factor",
+        "checkpointing"
+    };
+}
+
+bool available(){
+    return true;
+}
+
+void enable(){
+    enabled = true;
+}
+
+double now(){
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter( &count );
+    QueryPerformanceFrequency( &freq );
+    return static_cast<double>(count.QuadPart) / static_cast<double>(freq.QuadPart);
+#else
+    timespec t;
+    clock_gettime( CLOCK_MONOTONIC, &t );
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+#endif
+}
+
+void add( Section section, double seconds ){
+    Totals& t = totals[parallel::partition()][section];
+    t.seconds += seconds;
+    t.calls += 1;
+}
+
+void addItems( Section section, size_t items ){
+    totals[parallel::partition()][section].items += items;
+}
+
+void print( ostream& stream ){
+    if( !enabled ) return;
+    ios::fmtflags flags = stream.flags();
+    streamsize precision = stream.precision();
+    stream << "Profile (time is summed over threads; sections include those nested within):" << endl;
+    stream << left << setw(26) << "section" << right << setw(12) << "time (s)"
+        << setw(14) << "calls" << setw(16) << "items" << endl;
+    for( size_t s = 0; s < NUM_SECTIONS; ++s ){
+        Totals sum = { 0.0, 0, 0 };
+        for( size_t p = 0; p < parallel::MAX_THREADS; ++p ){
+            sum.seconds += totals[p][s].seconds;
+            sum.calls += totals[p][s].calls;
+            sum.items += totals[p][s].items;
+        }
+        stream << left << setw(26) << names[s] << right << setw(12)
+            << fixed << setprecision(3) << sum.seconds
+            << setw(14) << sum.calls << setw(16) << sum.items << endl;
+    }
+    stream.flags( flags );
+    stream.precision( precision );
+}
+
+}
+#else   // profiling compiled out
+
+bool profile::available(){
+    return false;
+}
+void profile::enable(){}
+void profile::print( ostream& ){}
+
+#endif
+
 } }
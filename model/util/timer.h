@@ -21,9 +21,84 @@
 #ifndef Hmod_timer
 #define Hmod_timer
 
+#include <cstddef>
+#include <ostream>
+
 namespace OM { namespace util { namespace timer {
   void startCheckpoint ();
   void stopCheckpoint ();
 } } }
 
+/** @brief Per-subsystem timers and counters (see --profile)
+ * 
+ * Only compiled in when OM_PROFILING is defined; otherwise the macros below
+ * expand to nothing. Time is wall-clock time summed over threads, so when
+ * updating humans on several threads a section may total more than the run
+ * time. Sections may be nested (e.g. WITHIN_HOST_UPDATE within
+ * POPULATION_UPDATE); each includes the time of those within it. */
+namespace OM { namespace util { namespace profile {
+    enum Section {
+        POPULATION_UPDATE,      ///< Population::update1
+        VECTOR_UPDATE,          ///< TransmissionModel::vectorUpdate
+        INTERVENTION_DEPLOY,    ///< InterventionManager::deploy
+        CTS_UPDATE,             ///< Continuous.update
+        NEW_SURVEY,             ///< Population::newSurvey and survey conclusion
+        WITHIN_HOST_UPDATE,     ///< WHInterface::update (per human)
+        DRUG_FACTOR,            ///< PK/PD drug factor (when drugs are present)
+        CHECKPOINT,             ///< reading and writing checkpoints
+        NUM_SECTIONS
+    };
+    
+    /// True if this build supports profiling (OM_PROFILING)
+    bool available();
+    
+    /// Start collecting (called when --profile is given)
+    void enable();
+    
+    /// Print a table of time, calls and items per section, if enabled.
+    void print( std::ostream& stream );
+    
+#ifdef OM_PROFILING
+    /// True once enable() was called
+    extern bool enabled;
+    
+    /// Monotonic clock in seconds
+    double now();
+    
+    /// Add one call taking the given time to a section's totals
+    void add( Section section, double seconds );
+    
+    /// Times a block: construct at the start, destroyed at the end.
+    class Scope {
+    public:
+        explicit Scope( Section s ) : section(s), start(enabled ? now() : -1.0) {}
+        ~Scope() {
+            if( start >= 0.0 ) add( section, now() - start );
+        }
+    private:
+        Section section;
+        double start;
+        // not copyable
+        Scope( const Scope& );
+        void operator=( const Scope& );
+    };
+    
+    /// Count items (e.g. humans) processed by a section, without timing
+    void addItems( Section section, size_t items );
+#endif
+} } }
+
+#ifdef OM_PROFILING
+/** Time the rest of the enclosing block as the given Section. */
+#define OM_PROFILE_SCOPE(section) \
+    ::OM::util::profile::Scope om_profile_scope( ::OM::util::profile::section )
+/** Count n items (e.g. humans) for the given Section. */
+#define OM_PROFILE_ITEMS(section, n) \
+    do{ if( ::OM::util::profile::enabled ) \
+        ::OM::util::profile::addItems( ::OM::util::profile::section, n ); }while(0)
+#else
+#define OM_PROFILE_SCOPE(section) do{}while(0)
+#define OM_PROFILE_ITEMS(section, n) do{}while(0)
+#endif
+
 #endif
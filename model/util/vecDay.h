@@ -63,6 +63,7 @@ struct vecDay {
     
     /// Access
     const vec_t& internal()const{ return v; }
+    inline vec_t& internal_vec(){ return v; }
     
     /// Checkpointing
     template<class S>
@@ -0,0 +1,98 @@
+#!/usr/bin/python
+# -*- coding: utf-8 -*-
+
+# This file is part of OpenMalaria.
+#
+# Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+# Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+#
+# OpenMalaria is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+# Usage: batch.py NAME [N]
+#
+# Runs N (default 3) copies of scenarioNAME.xml with openMalaria --batch
+# --jobs 1, and compares the output of each with expected/outputNAME.txt. The
+# copies have the same warm-up, so it is run once and shared by all jobs.
+#
+# Also runs the scenario once on its own and prints both times, as a
+# measure of the saving: without sharing, the batch would take about N times
+# as long as the single run.
+#
+# Exit status: 0 if all outputs match, 1 if not, -1 if unable to run.
+
+import sys
+import os
+import time
+import shutil
+import tempfile
+import subprocess
+
+sys.path.insert(0, "@CMAKE_CURRENT_BINARY_DIR@")
+import run
+import compareOutput
+
+def main(name, n):
+    scenarioSrc = os.path.join(run.testSrcDir, "scenario%s.xml" % name)
+    expected = os.path.join(run.testSrcDir, "expected/output%s.txt" % name)
+    schemaName = run.getSchemaName(scenarioSrc)
+    schema = os.path.join(run.testSrcDir, '../schema', schemaName)
+    if not os.path.isfile(schema):
+        schema = os.path.join(run.testBuildDir, '../schema', schemaName)
+
+    simDir = tempfile.mkdtemp(prefix="batch%s-" % name, dir=run.testBuildDir)
+    run.linkOrCopy(schema, os.path.join(simDir, schemaName))
+    batchFile = open(os.path.join(simDir, "batch.txt"), "w")
+    for i in range(n):
+        # a copy per job, since each job writes the checksum to its scenario's name
+        scenario = "scenario%s_%d.xml" % (name, i)
+        shutil.copy2(scenarioSrc, os.path.join(simDir, scenario))
+        batchFile.write("%s output%d.txt ctsout%d.txt\n" % (scenario, i, i))
+    batchFile.close()
+
+    base = [run.openMalariaExec, "--resource-path", simDir]
+    start = time.time()
+    ret = subprocess.call(base + ["--scenario", "scenario%s_0.xml" % name,
+            "--output", "single.txt", "--ctsout", "single-ctsout.txt"], cwd=simDir)
+    singleTime = time.time() - start
+    if ret != 0:
+        print("Single run failed with exit status %d" % ret)
+        return 1
+
+    start = time.time()
+    ret = subprocess.call(base + ["--batch", "batch.txt", "--jobs", "1"], cwd=simDir)
+    batchTime = time.time() - start
+    if ret != 0:
+        print("Batch failed with exit status %d" % ret)
+        return 1
+
+    for i in range(n):
+        r, ident = compareOutput.main(expected, os.path.join(simDir, "output%d.txt" % i), 0)
+        ret = max(ret, r)
+
+    print("Single run: %.2f s; batch of %d sharing a warm-up: %.2f s (%.2f s per job)"
+            % (singleTime, n, batchTime, batchTime / n))
+    if ret == 0:
+        shutil.rmtree(simDir)
+    return ret
+
+if __name__ == "__main__":
+    if len(sys.argv) not in (2, 3):
+        print("Usage: %s NAME [N]" % sys.argv[0])
+        sys.exit(-1)
+    try:
+        sys.exit(main(sys.argv[1], int(sys.argv[2]) if len(sys.argv) == 3 else 3))
+    except run.RunError as e:
+        print(str(e))
+        sys.exit(-1)
@@ -39,6 +39,7 @@ import gzip
 sys.path[0]="@CMAKE_SOURCE_DIR@/util"
 import compareOutput
 import compareCtsout
+import readBinaryOutput
 import xml.sax.handler
 
 class RunError(Exception):
@@ -146,6 +147,11 @@ def runScenario(options,omOptions,name):
     simDir = tempfile.mkdtemp(prefix=tmpprefix+'-', dir=testBuildDir)
     outputFile=os.path.join(simDir,"output.txt")
     outputGzFile=os.path.join(simDir,"output.txt.gz")
+    # With --output-format=binary, output.bin is converted to output.txt for
+    # comparison, so the expected (text) output checks both formats.
+    binaryFile=None
+    if "--output-format=binary" in omOptions:
+        binaryFile=os.path.join(simDir,"output.bin")
     ctsoutFile=os.path.join(simDir,"ctsout.txt")
     ctsoutGzFile=os.path.join(simDir,"ctsout.txt.gz")
     checkFile=os.path.join(simDir,"checkpoint")
@@ -162,7 +168,7 @@ def runScenario(options,omOptions,name):
     
     startTime=lastTime=time.time()
     # While no output.txt file and cmd exits successfully:
-    while (not os.path.isfile(outputFile)):
+    while (not os.path.isfile(binaryFile or outputFile)):
         if options.logging:
             print "\033[0;32m  "+(" ".join(cmd))+"\033[0;00m"
         ret=subprocess.call (cmd, shell=False, cwd=simDir)
@@ -199,6 +205,12 @@ def runScenario(options,omOptions,name):
     if ret == 0 and options.logging:
         print "\033[0;33mDone in " + str(time.time()-startTime) + " seconds"
     
+    if binaryFile is not None and os.path.isfile(binaryFile):
+        f_out = open(outputFile, 'w')
+        readBinaryOutput.writeText(readBinaryOutput.readBinaryOutput(binaryFile), f_out)
+        f_out.close()
+        os.remove(binaryFile)
+    
     if options.cleanup:
         os.remove(scenario_xsd)
         for f in (glob.glob(os.path.join(simDir,"checkpoint*")) + glob.glob(os.path.join(simDir,"seed?")) + [os.path.join(simDir,"init_data.xml"),os.path.join(simDir,"boinc_finish_called"),os.path.join(simDir,"scenario.sum")]):
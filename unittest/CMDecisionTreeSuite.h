@@ -229,6 +229,24 @@ public:
         TS_ASSERT_EQUALS( whm->lastTimeBlood.inDays(), -1*5 );
     }
     
+    void testMultiple(){
+        // all children of a 'multiple' node are executed
+        scnXml::DTMultiple multiple;
+        multiple.getTreatPKPD().push_back( scnXml::DTTreatPKPD( "sched1", "dosage1" ) );
+        multiple.setTreatSimple( scnXml::DTTreatSimple( "0t", "1t" ) );
+        scnXml::DecisionTree dt;
+        dt.setMultiple( multiple );
+        
+        const CMDecisionTree& cmdt = CMDecisionTree::create( dt, true );
+        whm->nTreatments = 0;
+        TS_ASSERT( cmdt.exec( *hd ).treated );
+        TS_ASSERT_EQUALS( whm->nTreatments, 2 );
+        TS_ASSERT_EQUALS( whm->lastTimeBlood.inDays(), 1*5 );
+        
+        // an equivalent tree is the same tree
+        TS_ASSERT_EQUALS( &CMDecisionTree::create( dt, true ), &cmdt );
+    }
+    
     double runAndGetMgPrescribed( scnXml::DecisionTree& dt, double age ){
         hd->ageYears = age;
         UnittestUtil::clearMedicateQueue( whm->pkpd );
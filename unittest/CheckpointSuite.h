@@ -24,10 +24,12 @@
 
 #include <cxxtest/TestSuite.h>
 #include "util/checkpoint.h"
+#include "util/errors.h"
 #include <sstream>
 #include <limits>
 #include <climits>
 #include <iomanip>
+#include <cstring>
 
 using namespace OM::util::checkpoint;
 
@@ -55,6 +57,50 @@ public:
 	orig.assert_equals (*test);
     }
     
+    void testHeader () {
+	std::stringstream ss;
+	ostream& os (ss);
+	istream& is (ss);
+	header (os);
+	TS_ASSERT_THROWS_NOTHING (header (is));
+	
+	// Header of a checkpoint written with another format version:
+	std::stringstream other;
+	const char bom[4] = { 'O', 'M', 'C', 'P' };
+	other.write (bom, 4);
+	(FORMAT_VERSION + 1) & static_cast<ostream&>(other);
+	TS_ASSERT_THROWS (header (static_cast<istream&>(other)), const OM::util::checkpoint_error&);
+    }
+    
+    void testFixedWidthLittleEndian () {
+	std::stringstream ss;
+	ostream& os (ss);
+	0x01020304 & os;
+	long (-2) & os;
+	std::string bytes = ss.str();
+	TS_ASSERT_EQUALS (bytes.size(), 12u);
+	TS_ASSERT_EQUALS (bytes[0], 0x04);
+	TS_ASSERT_EQUALS (bytes[3], 0x01);
+	for (size_t i = 4; i < 12; ++i)
+	    TS_ASSERT_EQUALS (static_cast<unsigned char>(bytes[i]), (i == 4 ? 0xFE : 0xFF));
+    }
+    
+    void testVectorDouble () {
+	std::stringstream ss;
+	ostream& os (ss);
+	istream& is (ss);
+	vector<double> v, w;
+	v.push_back (1.5);
+	v.push_back (-0.0);
+	v.push_back (numeric_limits<double>::max());
+	v & os;
+	w.push_back (7.0);
+	w & is;
+	TS_ASSERT_EQUALS (w.size(), v.size());
+	for (size_t i = 0; i < v.size(); ++i)
+	    TS_ASSERT_EQUALS (memcmp (&v[i], &w[i], sizeof(double)), 0);
+    }
+    
     struct TestObject {
 	TestObject () : x(-23263) {}
 	virtual ~TestObject () {}
@@ -0,0 +1,150 @@
+/*
+ This file is part of OpenMalaria.
+ 
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ 
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_CheckpointWriterSuite
+#define Hmod_CheckpointWriterSuite
+
+#include <cxxtest/TestSuite.h>
+#include "util/CheckpointWriter.h"
+#include "util/errors.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+using OM::util::CheckpointWriter;
+using OM::util::checkpoint_error;
+
+/** Tests the background checkpoint writer: files are written before the
+ * pointer is replaced, the pointer is replaced by renaming, and the old
+ * checkpoint is truncated last. Files are created in the working directory. */
+class CheckpointWriterSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp () {
+	removeFiles ();
+	// an old checkpoint, named by the pointer file
+	writeFile ("cwsuite_checkpoint0", "old checkpoint");
+	writeFile ("cwsuite_pointer", "0");
+    }
+    void tearDown () {
+	removeFiles ();
+    }
+    
+    void testWrite () {
+	if (!CheckpointWriter::available ()) return;
+	CheckpointWriter writer;
+	string data = "checkpoint data";
+	writer.write (data, "cwsuite_checkpoint1", false,
+		      "cwsuite_seed1", string ("seed\0data", 9),
+		      "cwsuite_pointer", "1", "cwsuite_checkpoint0");
+	TS_ASSERT (data.empty ());	// swapped out, not copied
+	writer.finish ();
+	
+	TS_ASSERT_EQUALS (readFile ("cwsuite_checkpoint1"), "checkpoint data");
+	TS_ASSERT_EQUALS (readFile ("cwsuite_seed1"), string ("seed\0data", 9));
+	TS_ASSERT_EQUALS (readFile ("cwsuite_pointer"), "1");
+	// the pointer was renamed into place
+	TS_ASSERT (!exists ("cwsuite_pointer.tmp"));
+	// the old checkpoint was truncated, not deleted
+	TS_ASSERT (exists ("cwsuite_checkpoint0"));
+	TS_ASSERT_EQUALS (readFile ("cwsuite_checkpoint0"), "");
+    }
+    
+    void testNoSeedOrTruncate () {
+	if (!CheckpointWriter::available ()) return;
+	CheckpointWriter writer;
+	string data = "checkpoint data";
+	writer.write (data, "cwsuite_checkpoint1", false, "", "",
+		      "cwsuite_pointer", "1", "");
+	writer.finish ();
+	TS_ASSERT_EQUALS (readFile ("cwsuite_pointer"), "1");
+	TS_ASSERT_EQUALS (readFile ("cwsuite_checkpoint0"), "old checkpoint");
+    }
+    
+    void testCompress () {
+	if (!CheckpointWriter::available ()) return;
+	CheckpointWriter writer;
+	string data = "checkpoint data";
+	writer.write (data, "cwsuite_checkpoint1.gz", true, "", "",
+		      "cwsuite_pointer", "1", "");
+	writer.finish ();
+	string gz = readFile ("cwsuite_checkpoint1.gz");
+	TS_ASSERT_LESS_THAN_EQUALS (2u, gz.size ());
+	if (gz.size () >= 2) {
+	    // gzip magic number
+	    TS_ASSERT_EQUALS (static_cast<unsigned char>(gz[0]), 0x1fu);
+	    TS_ASSERT_EQUALS (static_cast<unsigned char>(gz[1]), 0x8bu);
+	}
+    }
+    
+    // If the checkpoint can't be written, the pointer must still name the
+    // old checkpoint, which must be left intact.
+    void testCheckpointFailure () {
+	if (!CheckpointWriter::available ()) return;
+	CheckpointWriter writer;
+	string data = "checkpoint data";
+	writer.write (data, "cwsuite_missing/checkpoint1", false, "", "",
+		      "cwsuite_pointer", "1", "cwsuite_checkpoint0");
+	TS_ASSERT_THROWS (writer.finish (), const checkpoint_error&);
+	TS_ASSERT_EQUALS (readFile ("cwsuite_pointer"), "0");
+	TS_ASSERT_EQUALS (readFile ("cwsuite_checkpoint0"), "old checkpoint");
+    }
+    
+    // Likewise if the seed file can't be written; the checkpoint, written
+    // after the seed file, must not be written either.
+    void testSeedFailure () {
+	if (!CheckpointWriter::available ()) return;
+	CheckpointWriter writer;
+	string data = "checkpoint data";
+	writer.write (data, "cwsuite_checkpoint1", false,
+		      "cwsuite_missing/seed1", "seed data",
+		      "cwsuite_pointer", "1", "cwsuite_checkpoint0");
+	TS_ASSERT_THROWS (writer.finish (), const checkpoint_error&);
+	TS_ASSERT (!exists ("cwsuite_checkpoint1"));
+	TS_ASSERT_EQUALS (readFile ("cwsuite_pointer"), "0");
+	TS_ASSERT_EQUALS (readFile ("cwsuite_checkpoint0"), "old checkpoint");
+    }
+    
+private:
+    static void writeFile (const char* name, const string& content) {
+	ofstream f (name, ios::out | ios::binary);
+	f << content;
+    }
+    static string readFile (const char* name) {
+	ifstream f (name, ios::in | ios::binary);
+	ostringstream s;
+	s << f.rdbuf ();
+	return s.str ();
+    }
+    static bool exists (const char* name) {
+	ifstream f (name);
+	return f.is_open ();
+    }
+    static void removeFiles () {
+	const char* names[] = { "cwsuite_checkpoint0", "cwsuite_checkpoint1",
+	    "cwsuite_checkpoint1.gz", "cwsuite_seed1", "cwsuite_pointer",
+	    "cwsuite_pointer.tmp" };
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+	    std::remove (names[i]);
+    }
+};
+
+#endif
@@ -29,6 +29,8 @@
 #include "WithinHost/CommonWithinHost.h"
 #include "util/random.h"
 #include <limits>
+#include <algorithm>
+#include <vector>
 
 using namespace OM::WithinHost;
 
@@ -39,6 +41,8 @@ public:
         UnittestUtil::initTime(1);
         UnittestUtil::Infection_init_latentP_and_NaN ();
         EmpiricalInfection::init();
+        // expected densities below were generated with the rejection loop
+        EmpiricalInfection::rejectionSampling = true;
         util::random::seed (83);	// seed is unimportant, but must be fixed
         // pkpdID (1st value) isn't important since we're not using drug model here:
         infection = CommonWithinHost::createInfection( 0xFFFFFFFF );
@@ -112,7 +116,47 @@ public:
         TS_ASSERT_APPROX (infection->getDensity(), 1.97582432565095644);
     }
 
+    /* The truncated normal sampler should sample the same distribution as
+     * the rejection loop. Compare samples with a two-sample Kolmogorov-Smirnov
+     * test, with limits at which the loop often fails (so the result is
+     * capped), sometimes fails and hardly ever fails. */
+    void testLogDensitySampler () {
+        const EmpiricalInfection& inf = dynamic_cast<EmpiricalInfection&>( *infection );
+        const size_t ageDays = 5, N = 20000;
+        double mean, sd;
+        UnittestUtil::EmpiricalInfection_logDensityDistribution( inf, ageDays, mean, sd );
+        TS_ASSERT( sd > 0.0 );
+        
+        const double offsets[] = { -1.5, 0.0, 2.0 };
+        for( size_t i = 0; i < 3; ++i ){
+            const double limit = mean + offsets[i] * sd;
+            vector<double> a( N ), b( N );
+            for( size_t j = 0; j < N; ++j ){
+                a[j] = UnittestUtil::EmpiricalInfection_sampleLogDensity( inf, ageDays, limit, true );
+                b[j] = UnittestUtil::EmpiricalInfection_sampleLogDensity( inf, ageDays, limit, false );
+                TS_ASSERT_LESS_THAN_EQUALS( b[j], limit );
+            }
+            // critical value for a significance level of 1e-4
+            TS_ASSERT_LESS_THAN( ksStatistic( a, b ), 2.23 * sqrt( 2.0 / N ) );
+        }
+    }
+
 private:
+    /// Two-sample Kolmogorov-Smirnov statistic (sorts its arguments)
+    static double ksStatistic( vector<double>& a, vector<double>& b ){
+        sort( a.begin(), a.end() );
+        sort( b.begin(), b.end() );
+        size_t i = 0, j = 0;
+        double d = 0.0;
+        while( i < a.size() && j < b.size() ){
+            const double x = min( a[i], b[j] );
+            while( i < a.size() && a[i] == x ) ++i;   // ties: the cap is an atom
+            while( j < b.size() && b[j] == x ) ++j;
+            d = max( d, fabs( double(i) / a.size() - double(j) / b.size() ) );
+        }
+        return d;
+    }
+    
     CommonInfection* infection;
 };
 
@@ -50,6 +50,19 @@ public:
 	TS_ASSERT_APPROX (infection->immunitySurvivalFactor (100., 100., 1e8), 0.17081918453312689);
     }
     
+    void testPrecomputedMaternal () {
+	// Used by the descriptive model with one maternal term per host: must
+	// give identical results, not merely close ones
+	const double ages[] = { 0.1, 2., 100. }, hs[] = { 0., 1., 100. };
+	for (size_t a = 0; a < 3; ++a) {
+	    double dA = Infection::maternalImmunityFactor (ages[a]);
+	    for (size_t h = 0; h < 3; ++h) {
+		TS_ASSERT_EQUALS (infection->immunitySurvivalFactorDm (dA, hs[h], 1e8),
+			infection->immunitySurvivalFactor (ages[a], hs[h], 1e8));
+	    }
+	}
+    }
+    
 private:
     DummyInfection* infection;
 };
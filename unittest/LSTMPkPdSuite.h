@@ -90,6 +90,18 @@ public:
 	TS_ASSERT_APPROX (proxy->getDrugFactor (genotype, massAt21), 0.03174563637686205);
     }
     
+    void testCachedFactor () {
+	UnittestUtil::medicate( *proxy, MQ_index, 3000, 0, massAt21 );
+	const double factor = proxy->getDrugFactor (genotype, massAt21);
+	TS_ASSERT_EQUALS (proxy->getDrugFactor (genotype, massAt21), factor);
+	// medicating and decaying must invalidate the cached factor:
+	UnittestUtil::medicate( *proxy, MQ_index, 3000, 0, massAt21 );
+	const double factor2 = proxy->getDrugFactor (genotype, massAt21);
+	TS_ASSERT_LESS_THAN (factor2, factor);
+	proxy->decayDrugs (massAt21);
+	TS_ASSERT_DIFFERS (proxy->getDrugFactor (genotype, massAt21), factor2);
+    }
+    
 private:
     LSTMModel *proxy;
     uint32_t genotype;
@@ -0,0 +1,230 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_MosqTransmissionSuite
+#define Hmod_MosqTransmissionSuite
+
+#include <cxxtest/TestSuite.h>
+#include "UnittestUtil.h"
+#include "ExtraAsserts.h"
+
+#include "Transmission/Anopheles/MosqTransmission.h"
+#include "Transmission/Anopheles/EmergenceModel.h"
+#include "WithinHost/Genotypes.h"
+
+#include <cmath>
+
+using namespace OM::Transmission::Anopheles;
+using OM::WithinHost::Genotypes;
+
+/** Emergence model returning a constant number of new adults each day. */
+class MTS_ConstEmergence : public EmergenceModel {
+public:
+    MTS_ConstEmergence( double n ) : newAdults( n ) {}
+    virtual void init2( double, double, double, MosqTransmission& ){}
+    virtual bool initIterate( MosqTransmission& ){ return false; }
+    virtual double update( SimTime, double, double ){ return newAdults; }
+    virtual double getResAvailability() const{ return 0.0; }
+    virtual double getResRequirements() const{ return 0.0; }
+protected:
+    virtual void checkpoint( istream& ){}
+    virtual void checkpoint( ostream& ){}
+private:
+    double newAdults;
+};
+
+/** Compares MosqTransmission::update() against the straightforward
+ * implementation of the recurrences (NDEMD eq. 1.6, 1.7 and the N_v, O_v and
+ * S_v updates) it replaced. The two sum terms in a different order, so
+ * results agree to a small relative tolerance, not exactly. */
+class MosqTransmissionSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp () {
+        UnittestUtil::initTime(1);
+        Genotypes::initSingle();
+    }
+
+    void testVaryingParameters () {
+        MosqTransmission fast, ref;
+        setupModel( fast );
+        setupModel( ref );
+        for( int d = 0; d < 400; ++d ){
+            // varies every day, so nothing cached can be reused
+            double tsP_A = 0.68 + 0.05 * sin( d * 0.1 );
+            double tsP_df = 0.19 + 0.03 * cos( d * 0.07 );
+            double tsP_dif = 0.02 + 0.01 * sin( d * 0.05 );
+            step( fast, ref, d, tsP_A, tsP_df, tsP_dif, true );
+        }
+    }
+
+    void testPiecewiseConstantParameters () {
+        MosqTransmission fast, ref;
+        setupModel( fast );
+        setupModel( ref );
+        for( int d = 0; d < 400; ++d ){
+            // constant for a few weeks at a time, then a jump
+            int period = d / 23;
+            double tsP_A = 0.66 + 0.01 * (period % 5);
+            double tsP_df = 0.18 + 0.02 * (period % 3);
+            double tsP_dif = 0.01 + 0.002 * (d % 7);
+            step( fast, ref, d, tsP_A, tsP_df, tsP_dif, false );
+        }
+    }
+
+private:
+    void setupModel( MosqTransmission& m ){
+        // What MosqTransmission::initialise does, without the XML:
+        m.emergence = boost::shared_ptr<EmergenceModel>( new MTS_ConstEmergence( 1200.0 ) );
+        m.mosqRestDuration = sim::fromDays(3);
+        m.EIPDuration = sim::fromDays(10);
+        m.N_v_length = m.EIPDuration + m.mosqRestDuration;
+        m.minInfectedThreshold = 0.001;
+        m.fArray.resize( m.EIPDuration - m.mosqRestDuration + sim::oneDay() );
+        m.fArray[sim::zero()] = 1.0;
+        m.ftauArray.resize( m.EIPDuration );
+        for( SimTime i = sim::zero(); i < m.mosqRestDuration; i += sim::oneDay() )
+            m.ftauArray[i] = 0.0;
+        m.ftauArray[m.mosqRestDuration] = 1.0;
+        m.uninfected_v.resize( m.N_v_length );
+        m.histP_A.resize( m.N_v_length.inDays() );
+        m.histP_df.resize( m.N_v_length.inDays() );
+
+        vecDay<double> forcedS_v( sim::fromDays(365) );
+        for( SimTime t = sim::zero(); t < forcedS_v.size(); t += sim::oneDay() )
+            forcedS_v[t] = 90.0 + 10.0 * sin( t.inDays() * 0.3 );
+        m.initState( 0.68, 0.19, 47.619, 3.71429, forcedS_v );
+    }
+
+    void step( MosqTransmission& fast, MosqTransmission& ref, int d,
+               double tsP_A, double tsP_df, double tsP_dif, bool isDynamic )
+    {
+        const SimTime d0 = sim::fromDays(d);
+        vector<double> P_dif( Genotypes::N(), tsP_dif );
+        vector<double> eirFast( Genotypes::N(), 0.0 ), eirRef( Genotypes::N(), 0.0 );
+        fast.update( d0, tsP_A, tsP_df, P_dif, isDynamic, eirFast, 0.5 );
+        refUpdate( ref, d0, tsP_A, tsP_df, P_dif, isDynamic, eirRef, 0.5 );
+
+        const SimTime t1 = mod_nn( d0 + sim::oneDay(), fast.N_v_length );
+        TS_ASSERT_APPROX_TOL( fast.N_v[t1], ref.N_v[t1], 1e-10, 1e-10 );
+        for( size_t g = 0; g < Genotypes::N(); ++g ){
+            TS_ASSERT_APPROX_TOL( fast.O_v.at(t1,g), ref.O_v.at(t1,g), 1e-10, 1e-10 );
+            TS_ASSERT_APPROX_TOL( fast.S_v.at(t1,g), ref.S_v.at(t1,g), 1e-10, 1e-10 );
+            TS_ASSERT_APPROX_TOL( eirFast[g], eirRef[g], 1e-10, 1e-10 );
+        }
+        TS_ASSERT_APPROX_TOL( fast.timeStep_N_v0, ref.timeStep_N_v0, 1e-10, 1e-10 );
+    }
+
+    // MosqTransmission::update as it was before being vectorised
+    void refUpdate( MosqTransmission& m, SimTime d0, double tsP_A, double tsP_df,
+            const vector<double> tsP_dif, bool isDynamic,
+            vector<double>& partialEIR, double EIR_factor )
+    {
+        const SimTime N_v_length = m.N_v_length;
+        const SimTime mosqRestDuration = m.mosqRestDuration;
+        const SimTime EIPDuration = m.EIPDuration;
+        SimTime d1 = d0 + sim::oneDay();
+        SimTime d1Mod = d1 + N_v_length;
+        SimTime t1    = mod_nn(d1, N_v_length);
+        SimTime t0   = mod_nn(d0, N_v_length);
+        SimTime ttau = mod_nn(d1Mod - mosqRestDuration, N_v_length);
+
+        m.P_A[t1] = tsP_A;
+        m.P_df[t1] = tsP_df;
+        for( size_t i = 0; i < Genotypes::N(); ++i )
+            m.P_dif.at(t1,i) = tsP_dif[i];
+
+        for( SimTime n = sim::oneDay(); n <= mosqRestDuration; n += sim::oneDay() ){
+            const SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            m.fArray[n] = m.fArray[n-sim::oneDay()] * m.P_A[tn];
+        }
+        m.fArray[mosqRestDuration] += m.P_df[ttau];
+
+        const SimTime fAEnd = EIPDuration-mosqRestDuration;
+        for( SimTime n = mosqRestDuration+sim::oneDay(); n <= fAEnd; n += sim::oneDay() ){
+            const SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            m.fArray[n] =
+                m.P_df[tn] * m.fArray[n - mosqRestDuration]
+                + m.P_A[tn] * m.fArray[n-sim::oneDay()];
+        }
+
+        const SimTime fProdEnd = mosqRestDuration * 2;
+        for( SimTime n = mosqRestDuration+sim::oneDay(); n <= fProdEnd; n += sim::oneDay() ){
+            SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            m.ftauArray[n] = m.ftauArray[n-sim::oneDay()] * m.P_A[tn];
+        }
+        m.ftauArray[fProdEnd] += m.P_df[mod_nn(d1Mod-fProdEnd, N_v_length)];
+
+        for( SimTime n = fProdEnd+sim::oneDay(); n < EIPDuration; n += sim::oneDay() ){
+            SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            m.ftauArray[n] =
+                m.P_df[tn] * m.ftauArray[n - mosqRestDuration]
+                + m.P_A[tn] * m.ftauArray[n-sim::oneDay()];
+        }
+
+        for( SimTime d = sim::oneDay(); d < N_v_length; d += sim::oneDay() ){
+            SimTime t = mod_nn(d1Mod - d, N_v_length);
+            double sum = m.N_v[t];
+            for( size_t i = 0; i < Genotypes::N(); ++i ) sum -= m.O_v.at(t,i);
+            m.uninfected_v[d] = sum;
+        }
+
+        double total_S_v = 0.0;
+        for( size_t genotype = 0; genotype < Genotypes::N(); ++genotype ){
+            m.O_v.at(t1,genotype) = m.P_dif.at(ttau,genotype) * m.uninfected_v[mosqRestDuration]
+                        + m.P_A[t0]  * m.O_v.at(t0,genotype)
+                        + m.P_df[ttau] * m.O_v.at(ttau,genotype);
+
+            double sum = 0.0;
+            const SimTime ts = d1Mod - EIPDuration;
+            for( SimTime l = sim::oneDay(); l < mosqRestDuration; l += sim::oneDay() ){
+                const SimTime tsl = mod_nn(ts - l, N_v_length);
+                sum += m.P_dif.at(tsl,genotype) * m.P_df[ttau] * (m.uninfected_v[EIPDuration+l]) *
+                        m.ftauArray[EIPDuration+l-mosqRestDuration];
+            }
+
+            const SimTime tsm = mod_nn(ts, N_v_length);
+            m.S_v.at(t1,genotype) = m.P_dif.at(tsm,genotype) *
+                    m.fArray[EIPDuration-mosqRestDuration] * (m.uninfected_v[EIPDuration])
+                + sum
+                + m.P_A[t0]*m.S_v.at(t0,genotype)
+                + m.P_df[ttau]*m.S_v.at(ttau,genotype);
+
+            if( isDynamic ){
+                if ( m.S_v.at(t1,genotype) <= m.minInfectedThreshold ) {
+                    m.S_v.at(t1,genotype) = 0.0;
+                }
+            }
+
+            partialEIR[genotype] += m.S_v.at(t1, genotype) * EIR_factor;
+            total_S_v += m.S_v.at(t1, genotype);
+        }
+
+        const double nOvipositing = m.P_df[ttau] * m.N_v[ttau];
+        const double newAdults = m.emergence->update( d0, nOvipositing, total_S_v );
+        m.N_v[t1] = newAdults
+                    + m.P_A[t0]  * m.N_v[t0]
+                    + nOvipositing;
+        m.timeStep_N_v0 += newAdults;
+    }
+};
+
+#endif
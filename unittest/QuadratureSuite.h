@@ -0,0 +1,144 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_QuadratureSuite
+#define Hmod_QuadratureSuite
+
+#include <cxxtest/TestSuite.h>
+#include "PkPd/LSTMModel.h"
+#include "util/Quadrature.h"
+#include "UnittestUtil.h"
+#include "ExtraAsserts.h"
+
+#include <cmath>
+#include <ctime>
+#include <sstream>
+
+using namespace OM;
+using namespace OM::PkPd;
+namespace quadrature = OM::util::quadrature;
+
+struct QS_Poly {
+    double operator()( double x ) const{ return pow( x, 12 ) - 3.0 * x * x; }
+};
+/// Nearly a step function: far too steep for a single 15-point rule
+struct QS_Step {
+    double operator()( double x ) const{ return tanh( (x - 0.37) * 500.0 ); }
+};
+
+/** Tests the fixed-order integration used by the LSTM drug models, and
+ * compares drug factors against those computed with gsl_integration_qag
+ * alone. The comparison doubles as a benchmark: run with --trace to see
+ * timings. */
+class QuadratureSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp () {
+        UnittestUtil::initTime(1);
+        UnittestUtil::PkPdSuiteSetup();
+        bodymass = 50;
+    }
+    void tearDown () {
+        quadrature::fixedOrderEnabled() = true;
+        LSTMDrugType::clear();
+    }
+
+    void testPolynomial () {
+        // Both the Gauss and Kronrod rules are exact for polynomials of
+        // degree up to 13, so the error estimate is tiny
+        double result, err;
+        TS_ASSERT( quadrature::fixedOrder( QS_Poly(), 0.0, 1.3, 1e-10, 1e-10, result, err ) );
+        TS_ASSERT_APPROX_TOL( result, pow( 1.3, 13 ) / 13.0 - pow( 1.3, 3 ), 1e-13, 1e-13 );
+    }
+
+    void testFallback () {
+        double result, err;
+        TS_ASSERT( !quadrature::fixedOrder( QS_Step(), 0.0, 1.0, 1e-3, 1e-3, result, err ) );
+        quadrature::fixedOrderEnabled() = false;
+        TS_ASSERT( !quadrature::fixedOrder( QS_Poly(), 0.0, 1.3, 1e-10, 1e-10, result, err ) );
+    }
+
+    // Three-compartment model (Tarning 2012 AAC)
+    void testPPQ3 () {
+        const double dose = 18 * bodymass;   // 18 mg/kg * 50 kg
+        compare( "PPQ3", dose, 0.0 );
+    }
+    // Artemether with conversion to DHA
+    void testAR () {
+        const double dose = 1.7 * bodymass;   // 1.7 mg/kg * 50 kg
+        compare( "AR", dose, 0.5 );
+    }
+    // Artesunate with conversion to DHA
+    void testAS () {
+        const double dose = 4 * bodymass;   // 4 mg/kg * 50 kg
+        compare( "AS", dose, 0.5 );
+    }
+
+private:
+    /** Give three daily doses (each split over two times of day, to exercise
+     * integration over partial days) and compare daily drug factors
+     * computed with and without the fixed-order rule. */
+    void compare( const string& drugName, double dose, double secondTime ){
+        const size_t drugIndex = LSTMDrugType::findDrug( drugName );
+        const size_t days = 10, reps = 200;
+        LSTMModel fast, ref;
+        double tFast = 0.0, tRef = 0.0;
+        for( size_t d = 0; d < days; ++d ){
+            if( d < 3 ){
+                UnittestUtil::medicate( fast, drugIndex, 0.5 * dose, 0.0, bodymass );
+                UnittestUtil::medicate( fast, drugIndex, 0.5 * dose, secondTime, bodymass );
+                UnittestUtil::medicate( ref, drugIndex, 0.5 * dose, 0.0, bodymass );
+                UnittestUtil::medicate( ref, drugIndex, 0.5 * dose, secondTime, bodymass );
+            }
+            double facFast = 0.0, facRef = 0.0;
+            quadrature::fixedOrderEnabled() = true;
+            clock_t start = clock();
+            for( size_t i = 0; i < reps; ++i ){
+                UnittestUtil::clearDrugFactorCache( fast );
+                facFast = fast.getDrugFactor( 0, bodymass );
+            }
+            tFast += clock() - start;
+            quadrature::fixedOrderEnabled() = false;
+            start = clock();
+            for( size_t i = 0; i < reps; ++i ){
+                UnittestUtil::clearDrugFactorCache( ref );
+                facRef = ref.getDrugFactor( 0, bodymass );
+            }
+            tRef += clock() - start;
+
+            // An accepted fixed-order result is what QAG computes in its
+            // first step, so results agree to rounding
+            TS_ASSERT_APPROX_TOL( facFast, facRef, 1e-12, 1e-300 );
+
+            UnittestUtil::incrTime( sim::oneDay() );
+            fast.decayDrugs( bodymass );
+            ref.decayDrugs( bodymass );
+        }
+        ostringstream msg;
+        msg << drugName << ": fixed-order " << tFast / CLOCKS_PER_SEC
+            << "s, QAG " << tRef / CLOCKS_PER_SEC << "s";
+        TS_TRACE( msg.str().c_str() );
+    }
+
+    double bodymass;
+};
+
+#endif
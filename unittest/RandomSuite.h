@@ -0,0 +1,144 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_RandomSuite
+#define Hmod_RandomSuite
+
+#include <cxxtest/TestSuite.h>
+#include "UnittestUtil.h"
+#include "ExtraAsserts.h"
+#include "util/random.h"
+
+using namespace OM::util;
+
+class RandomSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp () {
+        UnittestUtil::initTime(5);
+        random::seed( 721, random::PHILOX );
+    }
+    void tearDown () {
+        random::seed( 0 );  // back to the default generator for other tests
+    }
+
+    void testPhiloxKnownAnswers () {
+        // Known-answer tests from the Random123 distribution (kat_vectors)
+        uint32_t out[4];
+        const uint32_t ctr1[4] = { 0, 0, 0, 0 };
+        const uint32_t key1[2] = { 0, 0 };
+        random::philox4x32_10( ctr1, key1, out );
+        TS_ASSERT_EQUALS( out[0], 0x6627e8d5u );
+        TS_ASSERT_EQUALS( out[1], 0xe169c58du );
+        TS_ASSERT_EQUALS( out[2], 0xbc57ac4cu );
+        TS_ASSERT_EQUALS( out[3], 0x9b00dbd8u );
+
+        const uint32_t ctr2[4] = { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu };
+        const uint32_t key2[2] = { 0xffffffffu, 0xffffffffu };
+        random::philox4x32_10( ctr2, key2, out );
+        TS_ASSERT_EQUALS( out[0], 0x408f276du );
+        TS_ASSERT_EQUALS( out[1], 0x41c83b0eu );
+        TS_ASSERT_EQUALS( out[2], 0xa20bc7c6u );
+        TS_ASSERT_EQUALS( out[3], 0x6d5451fdu );
+
+        const uint32_t ctr3[4] = { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u };
+        const uint32_t key3[2] = { 0xa4093822u, 0x299f31d0u };
+        random::philox4x32_10( ctr3, key3, out );
+        TS_ASSERT_EQUALS( out[0], 0xd16cfe09u );
+        TS_ASSERT_EQUALS( out[1], 0x94fdccebu );
+        TS_ASSERT_EQUALS( out[2], 0x5001e420u );
+        TS_ASSERT_EQUALS( out[3], 0x24126ea1u );
+    }
+
+    void testHumanStreamsIndependent () {
+        // Draws for human 1 alone:
+        random::Streams a( 1 );
+        double alone[6];
+        {
+            random::HumanContext ctx( a, random::PURPOSE_UPDATE );
+            for( int i = 0; i < 6; ++i ) alone[i] = random::uniform_01();
+        }
+
+        // The same draws interleaved with those of another human and those
+        // of another purpose must not change:
+        random::Streams a2( 1 ), b( 2 );
+        random::uniform_01();   // global stream
+        for( int i = 0; i < 6; ++i ){
+            random::HumanContext ctx( a2, random::PURPOSE_UPDATE );
+            {
+                random::HumanContext ctxB( b, random::PURPOSE_UPDATE );
+                random::gauss( 1.0 );
+            }
+            {
+                random::HumanContext ctxD( a2, random::PURPOSE_DEPLOY );
+                random::uniform_01();
+            }
+            TS_ASSERT_EQUALS( random::uniform_01(), alone[i] );
+        }
+
+        // Human 2's draws differ from human 1's:
+        random::Streams c( 2 );
+        random::HumanContext ctx( c, random::PURPOSE_UPDATE );
+        TS_ASSERT_DIFFERS( random::uniform_01(), alone[0] );
+    }
+
+    void testNewStep () {
+        random::Streams a( 5 );
+        double first;
+        {
+            random::HumanContext ctx( a, random::PURPOSE_UPDATE );
+            first = random::uniform_01();
+        }
+        // Next step: different numbers, and draw counts restart
+        UnittestUtil::incrTime( sim::oneTS() );
+        random::HumanContext ctx( a, random::PURPOSE_UPDATE );
+        TS_ASSERT_DIFFERS( random::uniform_01(), first );
+        TS_ASSERT_EQUALS( a.draws[random::PURPOSE_UPDATE], 1u );
+    }
+
+    void testUniformMean () {
+        random::Streams a( 3 );
+        random::HumanContext ctx( a, random::PURPOSE_UPDATE );
+        const int N = 100000;
+        double sum = 0.0;
+        for( int i = 0; i < N; ++i ){
+            double x = random::uniform_01();
+            TS_ASSERT( x >= 0.0 && x < 1.0 );
+            sum += x;
+        }
+        // standard error of the mean is 1/sqrt(12 N) ≈ 0.0009
+        TS_ASSERT_APPROX_TOL( sum / N, 0.5, 0.0, 0.005 );
+    }
+
+    void testGeometric () {
+        TS_ASSERT_EQUALS( random::geometric( 1.0 ), 0u );
+        // Skipping over slots selects each with probability p
+        const double p = 0.3;
+        const size_t N = 100000;
+        size_t selected = 0;
+        for( size_t i = random::geometric( p ); i < N; i += 1 + random::geometric( p ) )
+            ++selected;
+        // standard error of the proportion is sqrt(p(1-p)/N) ≈ 0.0014
+        TS_ASSERT_APPROX_TOL( double(selected) / N, p, 0.0, 0.008 );
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_SubPopMembershipSuite
+#define Hmod_SubPopMembershipSuite
+
+#include <cxxtest/TestSuite.h>
+#include "UnittestUtil.h"
+#include "Host/Human.h"
+#include "Host/SubPopMembership.h"
+
+using namespace OM;
+using Host::SubPopMembership;
+using interventions::ComponentId;
+
+class SubPopMembershipSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp () {
+        UnittestUtil::initTime(5);
+        // more than 64 components, so that some share a summary bit
+        SubPopMembership::init( 70 );
+        for( size_t i = 0; i < 3; ++i ){
+            humans[i] = UnittestUtil::createHuman( sim::zero() ).release();
+        }
+    }
+    void tearDown () {
+        for( size_t i = 0; i < 3; ++i ){
+            SubPopMembership::unlist( *humans[i] );
+            delete humans[i];
+        }
+        SubPopMembership::init( 0 );
+    }
+
+    void testMembership () {
+        Host::Human& human = *humans[0];
+        const ComponentId a( 3 ), b( 67 );
+        human.reportDeployment( a, sim::fromTS( 2 ) );
+        TS_ASSERT( human.isInSubPop( a ) );
+        TS_ASSERT( !human.isInSubPop( b ) );
+        human.reportDeployment( b, sim::fromTS( 1 ) );
+        TS_ASSERT( human.isInSubPop( b ) );
+
+        // b shares a's summary bit, so must survive a's removal
+        human.removeFromSubPop( a );
+        TS_ASSERT( !human.isInSubPop( a ) );
+        TS_ASSERT( human.isInSubPop( b ) );
+
+        UnittestUtil::incrTime( sim::oneTS() );
+        TS_ASSERT( !human.isInSubPop( b ) );
+    }
+
+    void testMembers () {
+        const ComponentId a( 5 );
+        // ids out of order with respect to deployment
+        const uint64_t ids[3] = { 7, 2, 4 };
+        for( size_t i = 0; i < 3; ++i ){
+            UnittestUtil::setHumanID( *humans[i], ids[i] );
+            humans[i]->reportDeployment( a, sim::fromTS( 2 ) );
+        }
+        humans[1]->removeFromSubPop( a );
+
+        vector<Host::Human*> members;
+        SubPopMembership::members( a, members );
+        TS_ASSERT_EQUALS( members.size(), 2u );
+        if( members.size() == 2 ){
+            TS_ASSERT_EQUALS( members[0], humans[2] );
+            TS_ASSERT_EQUALS( members[1], humans[0] );
+        }
+
+        // rejoining lists the human again
+        humans[1]->reportDeployment( a, sim::fromTS( 2 ) );
+        SubPopMembership::members( a, members );
+        TS_ASSERT_EQUALS( members.size(), 3u );
+
+        SubPopMembership::unlist( *humans[0] );
+        SubPopMembership::members( a, members );
+        TS_ASSERT_EQUALS( members.size(), 2u );
+        if( members.size() == 2 ){
+            TS_ASSERT_EQUALS( members[0], humans[1] );
+            TS_ASSERT_EQUALS( members[1], humans[2] );
+        }
+    }
+
+private:
+    Host::Human *humans[3];
+};
+
+#endif
@@ -34,6 +34,7 @@
 #include "WithinHost/Infection/Infection.h"
 #include "WithinHost/WHFalciparum.h"
 #include "WithinHost/Infection/MolineauxInfection.h"
+#include "WithinHost/Infection/EmpiricalInfection.h"
 #include "WithinHost/Genotypes.h"
 #include "mon/management.h"
 
@@ -484,12 +485,29 @@ public:
         pkpd.medicateQueue.clear();
     }
     
+    static void clearDrugFactorCache( PkPd::LSTMModel& pkpd ){
+        pkpd.factorCache.clear();
+    }
+    
+    static void EmpiricalInfection_logDensityDistribution( const WithinHost::EmpiricalInfection& inf,
+            size_t ageDays, double& mean, double& sd ){
+        inf.logDensityDistribution( ageDays, mean, sd );
+    }
+    static double EmpiricalInfection_sampleLogDensity( const WithinHost::EmpiricalInfection& inf,
+            size_t ageDays, double upperLimit, bool rejection ){
+        return rejection ? inf.sampleLogDensityRejection( ageDays, upperLimit ) :
+            inf.sampleLogDensity( ageDays, upperLimit );
+    }
+    
     static auto_ptr<Host::Human> createHuman(SimTime dateOfBirth){
         return auto_ptr<Host::Human>( new Host::Human(dateOfBirth) );
     }
     static void setHumanWH(Host::Human& human, WithinHost::WHInterface *wh){
         human.withinHostModel = wh;
     }
+    static void setHumanID(Host::Human& human, uint64_t id){
+        human.m_rng.id = id;
+    }
 };
 
 #endif
@@ -0,0 +1,77 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_WarmupKeySuite
+#define Hmod_WarmupKeySuite
+
+#include <cxxtest/TestSuite.h>
+#include "util/DocumentLoader.h"
+
+using OM::util::DocumentLoader;
+
+/** Tests which parts of a scenario affect the warm-up snapshot key. */
+class WarmupKeySuite : public CxxTest::TestSuite
+{
+public:
+    void testIgnoredParts () {
+        const string ref = key( "<om:scenario name=\"a\" wuID=\"1\">",
+                "<monitoring name=\"m\"><surveys/></monitoring>",
+                "<deployment><component id=\"x\"/><timed><deploy time=\"0\"/></timed></deployment>" );
+        // root attributes
+        TS_ASSERT_EQUALS( ref, key( "<om:scenario name=\"b\" wuID=\"7\">",
+                "<monitoring name=\"m\"><surveys/></monitoring>",
+                "<deployment><component id=\"x\"/><timed><deploy time=\"0\"/></timed></deployment>" ) );
+        // monitoring and deployments
+        TS_ASSERT_EQUALS( ref, key( "<om:scenario name=\"a\" wuID=\"1\">",
+                "<monitoring name=\"n\"><!-- x --><continuous/></monitoring>",
+                "<deployment name=\"y\"/><deployment><timed/></deployment>" ) );
+        // comments
+        TS_ASSERT_EQUALS( ref, DocumentLoader::hashWarmupInputs(
+                "<!-- start -->" + xml( "<om:scenario name=\"a\" wuID=\"1\">",
+                "<monitoring name=\"m\"><surveys/></monitoring>",
+                "<deployment><component id=\"x\"/><timed><deploy time=\"0\"/></timed></deployment>" ) ) );
+    }
+    
+    void testSignificantParts () {
+        const string ref = key( "<om:scenario>", "<monitoring/>", "" );
+        TS_ASSERT_EQUALS( ref.size(), 16u );
+        // components (not deployments) and model parameters are significant
+        TS_ASSERT_DIFFERS( ref, key( "<om:scenario>", "<monitoring/>",
+                "<component id=\"x\"/>" ) );
+        TS_ASSERT_DIFFERS( ref, DocumentLoader::hashWarmupInputs(
+                xml( "<om:scenario>", "<monitoring/>", "" ) + "<model/>" ) );
+        // an element whose name merely starts "deployment" is not skipped
+        TS_ASSERT_DIFFERS( ref, key( "<om:scenario>", "<monitoring/>",
+                "<deploymentX/>" ) );
+    }
+    
+private:
+    string xml( const string& root, const string& monitoring, const string& interventions ){
+        return "<?xml version=\"1.0\"?>\n" + root + "<demography popSize=\"100\"/>"
+            + monitoring + "<interventions>" + interventions + "</interventions>"
+            + "</om:scenario>";
+    }
+    string key( const string& root, const string& monitoring, const string& interventions ){
+        return DocumentLoader::hashWarmupInputs( xml( root, monitoring, interventions ) );
+    }
+};
+
+#endif
@@ -0,0 +1,144 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# This file is part of OpenMalaria.
+#
+# Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+# Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+#
+# OpenMalaria is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+"""Reader for the columnar binary survey output written by
+openMalaria --output-format=binary (see mon::internal::writeHeader).
+
+As a script, prints the data in the format of output.txt:
+
+    readBinaryOutput.py output.bin > output.txt
+
+(lines are not in the same order as openMalaria writes them, so compare with
+compareOutput.py rather than diff)."""
+
+import sys
+import gzip
+import struct
+from array import array
+
+MAGIC = b"OMCOLBIN"
+VERSION = 1
+
+# (name, array typecode) of category columns, in file order
+COLUMNS = [("age", "H"), ("cohort", "I"), ("species", "H"),
+           ("genotype", "H"), ("drug", "H")]
+VALUE_TYPES = {0: "i", 1: "d"}
+
+class Measure(object):
+    """Data of one output measure, as columns (arrays of equal length):
+    survey, age, cohort, species, genotype, drug and value. Categories use
+    the same numbers as output.txt; unused categories are 0."""
+    def __init__(self, typecode):
+        self.survey = array("I")
+        for name, code in COLUMNS:
+            setattr(self, name, array(code))
+        self.value = array(typecode)
+    def __len__(self):
+        return len(self.value)
+
+def _read(f, n):
+    data = f.read(n)
+    if len(data) != n:
+        raise IOError("unexpected end of file")
+    return data
+
+def _readArray(f, code, n, swap):
+    a = array(code)
+    data = _read(f, a.itemsize * n)
+    if sys.version_info[0] < 3:
+        a.fromstring(data)
+    else:
+        a.frombytes(data)
+    if swap:
+        a.byteswap()
+    return a
+
+def readBinaryOutput(fileName):
+    """Read a binary output file (optionally gzip-compressed).
+
+    Returns a dict of output measure number to Measure. The text header
+    (names of measures, age group bounds, etc.) is skipped."""
+    f = open(fileName, "rb")
+    if f.read(2) == b"\x1f\x8b":
+        f.close()
+        f = gzip.open(fileName, "rb")
+    else:
+        f.seek(0)
+    try:
+        if _read(f, 8) != MAGIC:
+            raise IOError(fileName + ": not an OpenMalaria binary output file")
+        # Numbers use the writer's byte order; the mark tells us which
+        order = "<"
+        version, mark = struct.unpack("<II", _read(f, 8))
+        if mark != 0x01020304:
+            order = ">"
+            version, mark = struct.unpack(">II", struct.pack("<II", version, mark))
+        if mark != 0x01020304:
+            raise IOError(fileName + ": bad byte order mark")
+        if version != VERSION:
+            raise IOError(fileName + ": unsupported format version %d" % version)
+        swap = (order == "<") != (sys.byteorder == "little")
+
+        length, = struct.unpack(order + "I", _read(f, 4))
+        _read(f, length)
+
+        data = dict()
+        blockHead = struct.Struct(order + "iIIB")
+        while True:
+            head = f.read(blockHead.size)
+            if len(head) == 0:
+                break
+            if len(head) != blockHead.size:
+                raise IOError(fileName + ": unexpected end of file")
+            measure, survey, nRows, valueType = blockHead.unpack(head)
+            typecode = VALUE_TYPES[valueType]
+            if measure not in data:
+                data[measure] = Measure(typecode)
+            m = data[measure]
+            m.survey.extend(array("I", [survey]) * nRows)
+            for name, code in COLUMNS:
+                getattr(m, name).extend(_readArray(f, code, nRows, swap))
+            m.value.extend(_readArray(f, typecode, nRows, swap))
+        return data
+    finally:
+        f.close()
+
+def writeText(data, out):
+    """Write data (as returned by readBinaryOutput) in the format of output.txt."""
+    for measure in sorted(data.keys()):
+        m = data[measure]
+        isInt = m.value.typecode == "i"
+        for i in range(len(m)):
+            if m.species[i] > 0:
+                col2 = m.species[i] + 1000000 * m.genotype[i]
+            elif m.drug[i] > 0:
+                col2 = m.age[i] + 1000 * m.cohort[i] + 1000000 * m.drug[i]
+            else:
+                col2 = m.age[i] + 1000 * m.cohort[i] + 1000000 * m.genotype[i]
+            value = str(m.value[i]) if isInt else "%g" % m.value[i]
+            out.write("%d\t%d\t%d\t%s\n" % (m.survey[i], col2, measure, value))
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.stderr.write("Usage: %s FILE\n" % sys.argv[0])
+        sys.exit(1)
+    writeText(readBinaryOutput(sys.argv[1]), sys.stdout)